@@ -0,0 +1,81 @@
+#ifndef _ASYNC_SEGMENT_WRITER_H_
+#define _ASYNC_SEGMENT_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "frame_queue.h"
+#include "segment_writer.h"
+
+
+struct AVPacketDeleter {
+    void operator()(AVPacket* pkt) const {
+        av_packet_free(&pkt);
+    }
+};
+
+using AVPacketPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
+
+
+/**
+ * 在独立 I/O 线程中执行另一个 SegmentWriter 的打开、写出与关闭
+ * 编码线程只转移包的引用后返回, 慢速存储上的 write/close/fsync 不在编码路径上
+ * 打开分段后待队列空闲时再准备下一个分段的文件 (fallocate), 不推迟新分段的写出
+ * 未写出的数据超过 MAX_PENDING_BYTES 时调用方阻塞, 限制内存占用
+ * I/O 错误在之后的调用中返回 -1
+ */
+class AsyncSegmentWriter : public SegmentWriter {
+public:
+    explicit AsyncSegmentWriter(std::unique_ptr<SegmentWriter> writer);
+    ~AsyncSegmentWriter() override;  // 写完已提交的内容后结束线程
+
+    AsyncSegmentWriter(const AsyncSegmentWriter&) = delete;
+    AsyncSegmentWriter& operator=(const AsyncSegmentWriter&) = delete;
+
+    int open(const std::string& path, const SegmentStream& stream) override;
+    int write(AVPacket* pkt) override;
+    void flush() override;
+    int close() override;
+    int wait() override;
+    bool is_open() const override { return open_; }
+    const char* extension() const override { return writer_->extension(); }
+    bool global_header() const override { return writer_->global_header(); }
+    void set_close_listener(SegmentListener listener) override;  // 在 I/O 线程中关闭完成后调用
+
+private:
+    enum class Op { Open, Write, Flush, Close };
+
+    struct Command {
+        Op op;
+        std::string path;
+        SegmentStream stream;
+        AVPacketPtr pkt;
+    };
+
+    void submit(Command command);
+    void execute(Command& command);
+    void io_thread();
+    int take_error() { return failed_.exchange(false) ? -1 : 0; }
+
+private:
+    static const int MAX_PENDING = 4096;                        // 未写出的命令数上限
+    static constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;  // 未写出的包字节数上限
+
+    std::unique_ptr<SegmentWriter> writer_;
+    FrameQueue<Command> queue_{MAX_PENDING};
+    std::thread thread_;
+    bool open_ = false;  // 调用方视角的打开状态
+    std::atomic<bool> failed_{false};
+
+    std::mutex pending_mtx_;
+    std::condition_variable pending_cv_;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+};
+
+
+#endif
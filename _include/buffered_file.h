@@ -0,0 +1,87 @@
+#ifndef _BUFFERED_FILE_H_
+#define _BUFFERED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * 落盘策略
+ */
+enum class FsyncPolicy {
+    None,     // 交给内核回写
+    Segment,  // 分段关闭前 fsync
+    Batch,    // 每批写出后 fdatasync, 关闭前 fsync
+};
+
+
+/**
+ * 分段文件的写出参数
+ */
+struct WriterOptions {
+    size_t buffer_size = 1 << 20;  // 批量写出的字节数, 向上取整到 BLOCK_SIZE
+    bool direct_io = false;        // O_DIRECT 绕过页缓存
+    FsyncPolicy fsync = FsyncPolicy::None;
+    bool preopen = true;            // 打开分段时预先创建下一个文件并预分配空间
+    size_t preallocate_bytes = 0;   // 预分配字节数, 0 表示按上一个分段的大小
+};
+
+
+/**
+ * 带对齐缓冲区的输出文件
+ * 写入先进入缓冲区, 缓冲区满时整块写出, 减少小包造成的系统调用与 NFS 往返
+ * direct_io 时整块按 BLOCK_SIZE 对齐写出; 文件系统不支持 O_DIRECT 时退回普通写入,
+ * 不足一块的尾部与 seek 之后的写入改为普通写入
+ * preopen 时打开后由调用方在空闲时调用 prepare_spare, 在同一目录预先创建下一个文件并 fallocate,
+ * 下次打开只需重命名, 文件在磁盘上连续; 关闭时截断到实际大小, 释放多余的预分配空间
+ * 首次打开某个目录时删除已退出的进程遗留的预备文件
+ */
+class BufferedFile {
+public:
+    explicit BufferedFile(const WriterOptions& options);
+    ~BufferedFile();
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+public:
+    int open(const std::string& path);  // 有预先创建的文件时重命名为 path
+    int write(const uint8_t* data, size_t size);
+    int64_t seek(int64_t offset, int whence);  // 返回新的文件位置, 失败返回 -1
+    int64_t size();
+    int flush();  // 缓冲数据交给内核; direct_io 时保留不足一块的尾部
+    int close();  // 写出剩余数据, 按策略落盘后关闭
+    void prepare_spare();  // preopen 时每次打开后至多执行一次, 不在打开的路径上
+    bool is_open() const { return fd_ >= 0; }
+
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;  // O_DIRECT 要求的地址、长度与偏移对齐
+
+private:
+    int write_out(size_t size);
+    int disable_direct();
+    int open_file(const std::string& path, bool& direct);
+    void discard_spare();
+    static void remove_stale_spares(const std::string& dir);
+
+private:
+    WriterOptions options_;
+    int fd_ = -1;
+    bool direct_ = false;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+
+    // 预先创建的下一个文件
+    int spare_fd_ = -1;
+    bool spare_direct_ = false;
+    bool spare_due_ = false;  // 本次打开后尚未准备
+    std::string spare_path_;
+    std::string dir_;          // 当前文件所在目录
+    std::string cleaned_dir_;  // 已清理遗留预备文件的目录
+    size_t last_size_ = 0;  // 上一个分段的大小
+};
+
+
+#endif
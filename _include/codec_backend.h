@@ -0,0 +1,42 @@
+#ifndef _CODEC_BACKEND_H_
+#define _CODEC_BACKEND_H_
+
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/dict.h>
+}
+
+struct EncoderSettings;
+
+
+/**
+ * 软件编码器后端
+ * EncoderSettings 中的 preset 统一使用 x264 的档位名 (ultrafast ... veryslow), 由各后端换算为自己的参数
+ */
+struct CodecBackend {
+    const char* name;       // FFmpeg 编码器名称
+    const char* alias;      // 简称, 如 h264/hevc/av1
+    const char* extension;  // 分段文件扩展名 (裸码流)
+    double default_crf;     // 编码器默认的 CRF, 用于速度控制的起点
+    double max_crf;         // 速度控制允许提高到的 CRF 上限
+    bool force_keyframe;    // 帧类型设为 I 即可强制 IDR, 否则切分分段时需重新打开编码器
+    // 将通用参数换算为编码器选项
+    void (*apply)(const EncoderSettings& settings, AVCodecContext* ctx, AVDictionary** opts);
+};
+
+
+/**
+ * 按编码器名称或简称查找, 不支持返回 nullptr
+ */
+const CodecBackend* find_codec_backend(const std::string& name);
+
+
+// preset 档位, 由快到慢
+static const int PRESET_LEVELS = 9;
+int preset_level(const std::string& preset);  // 不在档位表中返回 -1
+const char* preset_name(int level);
+
+
+#endif
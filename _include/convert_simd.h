@@ -0,0 +1,37 @@
+#ifndef _CONVERT_SIMD_H_
+#define _CONVERT_SIMD_H_
+
+#include <cstdint>
+
+
+/**
+ * BGR24 -> YUV420P (BT.601 有限范围) 转换函数
+ * 色度取 2x2 像素均值; 宽高可为奇数, 末行/末列按复制边界处理
+ */
+typedef void (*Bgr24ToI420Func)(const uint8_t* src, int src_stride,
+                                uint8_t* dst_y, int stride_y,
+                                uint8_t* dst_u, int stride_u,
+                                uint8_t* dst_v, int stride_v,
+                                int width, int height);
+
+
+void bgr24_to_i420_c(const uint8_t* src, int src_stride,
+                     uint8_t* dst_y, int stride_y,
+                     uint8_t* dst_u, int stride_u,
+                     uint8_t* dst_v, int stride_v,
+                     int width, int height);
+
+/**
+ * 按运行时 CPU 特性选择向量化实现 (AVX2 > SSSE3), 均不支持时返回 nullptr, 由调用方退回 swscale
+ */
+Bgr24ToI420Func select_bgr24_to_i420();
+
+const char* bgr24_to_i420_name(Bgr24ToI420Func func);
+
+/**
+ * 按名称 (c / ssse3 / avx2) 取得指定实现, 未编译或 CPU 不支持时返回 nullptr, 供测试与基准使用
+ */
+Bgr24ToI420Func find_bgr24_to_i420(const char* name);
+
+
+#endif
@@ -5,6 +5,7 @@
 
 
 #include <iostream>
+#include <algorithm>
 #include <thread>
 #include <atomic>
 #include <chrono>
@@ -13,6 +14,10 @@
 #include <filesystem>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <map>
+#include <optional>
+#include <functional>
 
 // opencv 相关头文件
 #include <opencv4/opencv2/opencv.hpp>
@@ -23,34 +28,115 @@
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
-#include <libswscale/swscale.h>
-#include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
 }
 
+#include "codec_backend.h"
+#include "segment_writer.h"
+#include "segment_catalog.h"
+#include "packet_sink.h"
+
+
+/**
+ * 编码参数, 需在 init 之前设置
+ * crf/qp 小于 0 表示使用编码器默认的码率控制
+ */
+struct EncoderSettings {
+    std::string codec = "libx264";    // 编码器名称或简称 (h264/hevc/av1), 见 codec_backend.cpp
+    std::string container = "raw";    // 分段封装: raw 裸码流 / mp4 分片 MP4 / mkv Matroska
+    std::string preset = "medium";
+    std::string tune;                 // 如 zerolatency, 为空不设置
+    std::string profile = "main";
+    double crf = -1;                  // 恒定质量因子
+    int qp = -1;                      // 固定量化参数
+    int gop = 5;                      // 关键帧间隔 (帧数)
+    int bframes = 0;                  // B 帧数目
+    int threads = 0;                  // 编码线程数, 0 表示自动
+    int slices = 0;                   // 每帧条带数, 0 表示不切分
+    int fps = 10;                     // 编码视频帧率
+    int segment_frames = 30;          // 分段帧数上限, 0 表示不按帧数切分
+    double segment_seconds = 0;       // 分段时长上限 (秒), 0 表示不按时长切分
+    int64_t segment_bytes = 0;        // 分段字节数上限, 0 表示不按大小切分
+    bool low_latency = false;         // 低延迟模式: 条带多线程、无前瞻、帧内刷新、逐包落盘
+    bool async_io = true;             // 编码包交给独立 I/O 线程写出, 存储延迟不阻塞编码
+    int io_buffer_kb = 1024;          // 写出缓冲区大小, 按此批量写入
+    bool direct_io = false;           // O_DIRECT 绕过页缓存, 文件系统不支持时退回普通写入
+    FsyncPolicy fsync = FsyncPolicy::None;  // 落盘策略
+    bool preallocate = true;          // 预先创建下一个分段文件并按预计大小预分配磁盘空间, 仅 async_io 时生效
+    std::map<std::string, std::string> options;  // 透传给编码器的其他选项
+};
+
+
+/**
+ * 帧延迟统计: 从进入 PushWork 到编码数据写出的时间
+ */
+struct LatencyStats {
+    uint64_t count = 0;
+    double last_ms = 0;
+    double avg_ms = 0;
+    double max_ms = 0;
+
+    void add(double ms) {
+        count++;
+        last_ms = ms;
+        avg_ms += (ms - avg_ms) / count;
+        max_ms = std::max(max_ms, ms);
+    }
+
+    void merge(const LatencyStats& other) {
+        if (other.count == 0) {
+            return;
+        }
+        avg_ms = (avg_ms * count + other.avg_ms * other.count) / (count + other.count);
+        count += other.count;
+        last_ms = other.last_ms;
+        max_ms = std::max(max_ms, other.max_ms);
+    }
+};
 
+
+/**
+ * 编码阶段: 接收已转换为编码格式的图像帧, 编码并写入分段文件
+ */
 class Encoder {
 public:
-    Encoder(int width, int height);
+    Encoder(int width, int height, AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P);
     ~Encoder();
 
 public:
     int init();
-    int frame_process(const cv::Mat& mat);
+    int encode_frame(AVFrame* frame);
     void encode_end();
+    int set_settings(const EncoderSettings& settings);
+    int reconfigure(const EncoderSettings& settings);  // 下一分段起生效
+    EncoderSettings settings() const;
+    bool at_segment_boundary() const;  // 下一帧开始新的分段
+    LatencyStats latency() const;
+    uint64_t encoded_frames() const { return encoded_frames_.load(); }
+    uint64_t encoded_bytes() const { return encoded_bytes_.load(); }
+    std::string segment_name() const;
+    void set_segment_suffix(const std::string& suffix) { segment_suffix_ = suffix; }  // init 之前调用
+    void set_segment_dir(const std::string& dir) { segment_dir_ = dir; }  // init 之前调用, 为空时写入当前目录
+    void set_catalog(std::shared_ptr<SegmentCatalog> catalog) { catalog_ = std::move(catalog); }  // init 之前调用
+    void set_segment_listener(SegmentListener listener) { segment_listener_ = std::move(listener); }  // init 之前调用, 分段文件关闭完成后通知
+    void add_sink(std::shared_ptr<PacketSink> sink) { sinks_.push_back(std::move(sink)); }  // init 之前调用
+
+    // 由调用方管理分段, 与 encode_frame 的自动切分二选一
+    int open_segment(const std::string& filename);
+    int write_frame(AVFrame* frame);
+    int close_segment();
 
 private:
-    int alloc_input_frame();
-    int alloc_push_frame();
     int codec_init();
-    int init_convert();  // 创建转换器对象
-    int update_output_file();
+    int reopen_codec();
     int encode_write(AVFrame* p_frame = nullptr);
-    int encode_call();
-
-private:
-    static void validate_frame_and_mat(const cv::Mat& mat, const AVFrame* frame);
-    static void validate_pixel_format(const cv::Mat& mat, AVPixelFormat format);
+    bool rollover_due() const;
+    int start_segment(const std::string& filename);
+    int close_writer();
+    static std::unique_ptr<SegmentWriter> create_writer(const EncoderSettings& settings);
+    int64_t take_enqueue_us(int64_t packet_pts, int64_t packet_dts);
+    void record_latency(int64_t enqueue_us);
+    void record_catalog(int64_t packet_pts, int64_t enqueue_us, bool key);
 
 
 public:
@@ -58,20 +144,44 @@ public:
     int height_ = 2048;
 
 private:
-    AVFrame* frame_in = nullptr;  // 转换前的图像帧
-    AVFrame* push_frame = nullptr;  // 转换后的图像帧
+    AVPixelFormat pix_fmt_ = AV_PIX_FMT_YUV420P;  // 编码的图像格式
     AVPacket* pkt = nullptr;  // 
-    SwsContext* sws_ctx_ = nullptr;
     const AVCodec *codec = nullptr;
     AVCodecContext *codec_ctx = nullptr;
+    EncoderSettings settings_;
+    const CodecBackend* backend_ = find_codec_backend("libx264");
+    std::optional<EncoderSettings> pending_settings_;  // 待下一分段应用的编码参数
+    mutable std::mutex settings_mtx_;
+
+    // 帧延迟: frame->opaque 携带帧的入队时刻 (get_time_us), 按 pts 与输出包对应
+    std::map<int64_t, int64_t> enqueue_us_;
+    static constexpr size_t MAX_PENDING_FRAMES = 1024;  // 编码器内缓存帧数的上限, 超出的最早记录视为不再输出
+    LatencyStats latency_;
+    mutable std::mutex latency_mtx_;
 
 private:
     int64_t pts = 0;  // 时间戳
-    int fps_ = 10;  // 编码视频帧率
     uint64_t frame_count = 0;  // 帧计数变量
-    static const int FRAMES_PER_FILE = 30;  // 单个编码文件的图像帧数目
+    std::atomic<uint64_t> encoded_frames_{0};  // 已写出的编码包数
+    std::atomic<uint64_t> encoded_bytes_{0};   // 已写出的字节数
     
-    FILE* output_file_ = nullptr;  // 当前编码输出文件
+    std::unique_ptr<SegmentWriter> writer_;  // 当前分段的写出方式, init 时按参数创建
+    std::string segment_suffix_;  // 分段文件名后缀, 区分同一输入的多路输出
+    std::string segment_dir_;     // 自动切分的分段文件所在目录
+    std::string segment_path_;    // 当前分段文件
+    int64_t segment_bytes_ = 0;   // 当前分段已写出的编码字节数
+    int frames_in_segment_ = 0;   // 当前分段已送入编码器的帧数
+    int64_t segment_start_us_ = 0;  // 当前分段开始的时刻 (get_time_us)
+
+    // 强制关键帧切分: 输出 pts 不小于 cut_pts_ 的关键帧包时切换到 next_segment_
+    int64_t cut_pts_ = AV_NOPTS_VALUE;
+    std::string next_segment_;
+
+    // 分段目录: 新分段的第一个输出包写出时登记分段
+    std::shared_ptr<SegmentCatalog> catalog_;
+    bool segment_cataloged_ = true;
+    SegmentListener segment_listener_;
+    std::vector<std::shared_ptr<PacketSink>> sinks_;  // 与分段文件并列的其他输出, 共用同一次编码
     bool initialized_ = false;
 };
 
@@ -0,0 +1,94 @@
+#ifndef _FRAME_CONVERTER_H_
+#define _FRAME_CONVERTER_H_
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// opencv 相关头文件
+#include <opencv4/opencv2/opencv.hpp>
+#include <opencv4/opencv2/core.hpp>
+
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+#include "frame_item.h"
+#include "thread_pool.h"
+#include "convert_simd.h"
+
+
+struct AVFrameDeleter {
+    void operator()(AVFrame* frame) const {
+        av_frame_free(&frame);
+    }
+};
+
+using AVFramePtr = std::unique_ptr<AVFrame, AVFrameDeleter>;
+
+
+/**
+ * 以 AV_FRAME_DATA_REGIONS_OF_INTEREST 附加到帧上, 超出图像的部分被裁剪, 裁剪后为空的区域忽略
+ */
+int attach_rois(AVFrame* frame, const std::vector<RoiRect>& rois);
+
+
+/**
+ * 输入图像 -> 编码器图像帧的转换
+ * 输出帧的缓冲区取自 AVBufferPool, 引用计数归零后自动回收, 不在每帧路径上分配内存
+ */
+class FrameConverter {
+public:
+    FrameConverter(int width, int height, AVPixelFormat in_fmt = AV_PIX_FMT_BGR24);
+    ~FrameConverter();
+
+    FrameConverter(const FrameConverter&) = delete;
+    FrameConverter& operator=(const FrameConverter&) = delete;
+
+public:
+    int init();
+    AVFramePtr convert(const cv::Mat& mat);  // 失败返回空指针
+    int set_convert_threads(int num_threads);
+    void set_simd_convert(bool enable);
+
+    AVPixelFormat input_format() const { return in_fmt_; }
+    AVPixelFormat output_format() const;
+    int input_rows() const;
+    int input_channels() const;
+
+private:
+    AVFramePtr alloc_output_frame();
+    int init_convert();  // 创建转换器对象
+    int convert_frame(AVFrame* dst);
+    int copy_gray(const cv::Mat& mat, AVFrame* dst);
+    int copy_yuv(const cv::Mat& mat, AVFrame* dst);
+
+    static void validate_frame_and_mat(const cv::Mat& mat, const AVFrame* frame);
+    static void validate_pixel_format(const cv::Mat& mat, AVPixelFormat format);
+
+public:
+    int width_ = 2432;
+    int height_ = 2048;
+
+private:
+    AVPixelFormat in_fmt_ = AV_PIX_FMT_BGR24;  // 输入图像格式
+    AVFrame* frame_in = nullptr;  // 转换前的图像帧, 数据指针指向 cv::Mat 的缓冲区
+
+    // 输出帧各平面的缓冲池
+    AVBufferPool* plane_pools_[4] = {nullptr};
+    int plane_linesizes_[4] = {0};
+    int plane_count_ = 0;
+
+    std::vector<SwsContext*> sws_ctxs_;  // 每个水平条带一个转换器
+    std::unique_ptr<ThreadPool> convert_pool_;
+    int convert_threads_ = 1;  // 颜色转换的并行条带数
+    bool simd_convert_ = true;  // 优先使用向量化转换内核
+    Bgr24ToI420Func bgr_kernel_ = nullptr;  // 为空时使用 swscale
+};
+
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _FRAME_ITEM_H_
+#define _FRAME_ITEM_H_
+
+#include <memory>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+#include "utils.h"
+
+
+/**
+ * 感兴趣区域, 坐标为像素; qoffset 取值 [-1, 1], 负值表示提高画质, 正值表示加大压缩
+ */
+struct RoiRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    float qoffset = 0;
+};
+
+
+/**
+ * 队列中传递的图像帧
+ * holder 为 mat 底层缓冲区的所有者 (例如 Python 侧的 numpy 数组), 帧处理完毕后随之释放
+ */
+struct FrameItem {
+    cv::Mat mat;
+    std::shared_ptr<void> holder;
+    int64_t enqueue_us = 0;  // 进入 PushWork 的时刻, 用于统计端到端延迟
+    std::vector<RoiRect> rois;  // 编码时附加的感兴趣区域
+
+    FrameItem() = default;
+    explicit FrameItem(cv::Mat _mat, std::shared_ptr<void> _holder = nullptr) 
+        : mat(std::move(_mat)), holder(std::move(_holder)), enqueue_us(get_time_us()) {}
+};
+
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef _FRAMEPOOL_H_
+#define _FRAMEPOOL_H_
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+/**
+ * 预分配的图像帧缓冲池
+ * 槽位状态: 空闲 -> acquire 取出 (调用方写入) -> commit 提交 (入队处理中) -> release_committed 归还
+ * 取出但未提交的槽位由 release 归还; 已提交的槽位只能由处理完成的一方归还, 调用方不能再写入或归还
+ */
+class FramePool {
+public:
+    FramePool(int count, int width, int height, int channels);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+public:
+    int acquire(int timeout_ms = -1);  // 返回槽位号, 超时或停止返回 -1
+    bool commit(int slot);  // 取出 -> 已提交, 槽位不是取出状态时返回 false
+    bool release(int slot);  // 放弃取出的槽位, 槽位不是取出状态 (包括已提交) 时返回 false
+    void release_committed(int slot);  // 已提交的槽位处理完成后归还
+    bool is_acquired(int slot) const;
+    void stop();
+
+    cv::Mat mat(int slot) const;  // 槽位对应的 Mat 视图, 不持有缓冲区
+    uint8_t* data(int slot) const;
+    size_t available() const;
+
+    int count() const { return static_cast<int>(buffers_.size()); }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const { return channels_; }
+    size_t frame_bytes() const { return frame_bytes_; }
+
+private:
+    enum class SlotState {
+        Free,
+        Acquired,
+        Committed,
+    };
+
+    bool set_free(int slot, SlotState from);
+
+private:
+    static const size_t ALIGNMENT = 64;  // 缓存行对齐, 便于 SIMD 读取
+
+    std::vector<uint8_t*> buffers_;
+    std::vector<int> free_slots_;
+    std::vector<SlotState> states_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    bool stop_ = false;
+
+    int width_;
+    int height_;
+    int channels_;
+    size_t frame_bytes_;
+};
+
+
+#endif
@@ -7,13 +7,29 @@
 #include <condition_variable>
 #include <optional>
 #include <chrono>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
 
 
 template<typename T>
 struct PopResult {
     std::optional<T> item;
     bool is_stopped;
-    PopResult(std::optional<T> _item, bool _is_stopped) : item(_item), is_stopped(_is_stopped) {}
+    PopResult(std::optional<T> _item, bool _is_stopped) : item(std::move(_item)), is_stopped(_is_stopped) {}
+};
+
+
+/**
+ * 队列满时的处理策略
+ */
+enum class OverflowPolicy {
+    Block,       // 阻塞等待空间, 超时后丢弃新元素
+    DropNewest,  // 立即丢弃新元素
+    DropOldest,  // 挤出队首最旧的元素
+    LatestOnly,  // 清空队列, 只保留最新元素
 };
 
 
@@ -40,55 +56,133 @@ public:
     }
 
     /**
-     * 添加元素
-     * timeout = -1 表示无限等待
+     * 队列中元素占用的总字节数, 未设置字节上限时为 0
      */
-     bool push(const T& item, int timeout_ms = -1) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        // 等待队列未满或停止信号
-        auto wait_predicate = [this] { 
-            return !stop_ && queue_.size() < max_size_; 
-        };
-        if (!cond_var_.wait_for(lock, get_timeout(timeout_ms), wait_predicate)) {
-            return false;
+    size_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+    /**
+     * 设置字节上限, sizer 计算单个元素的字节数; max_bytes = 0 表示不限制
+     * 队列为空时总能放入一个元素, 避免超大元素永远无法入队
+     */
+    void set_byte_budget(size_t max_bytes, std::function<size_t(const T&)> sizer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_bytes_ = max_bytes;
+        sizer_ = std::move(sizer);
+        bytes_ = 0;
+        if (sizer_) {
+            // std::queue 不支持遍历, 借助临时队列重新统计
+            std::queue<T> tmp;
+            while (!queue_.empty()) {
+                bytes_ += sizer_(queue_.front());
+                tmp.push(std::move(queue_.front()));
+                queue_.pop();
+            }
+            queue_.swap(tmp);
+        }
+    }
+
+    /**
+     * 当前是否能放入 item_bytes 字节的元素
+     */
+    bool can_accept(size_t item_bytes) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !stop_ && !is_full(item_bytes);
+    }
+
+    /**
+     * 非阻塞添加元素, 不执行满队列策略也不计入丢弃
+     * 成功时 item 被移入队列, 失败时 item 保持不变
+     */
+    bool try_push(T& item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t item_bytes = item_size(item);
+            if (stop_ || is_full(item_bytes)) {
+                return false;
+            }
+            bytes_ += item_bytes;
+            queue_.push(std::move(item));
+            accepted_++;
         }
-        queue_.push(item);
-        cond_var_.notify_one();  // 通知一个等待消费者
+        cond_var_.notify_one();
         return true;
     }
 
+    /**
+     * 添加元素, 队列满时按 policy_ 处理
+     * timeout = -1 表示无限等待, 仅 Block 策略下生效
+     */
+    bool push(T item, int timeout_ms = -1) {
+        std::vector<T> evicted;  // 被挤出的元素在解锁后释放
+        bool ret;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ret = enqueue_locked(item, lock, timeout_ms, get_deadline(timeout_ms), evicted);
+        }
+        if (ret) {
+            cond_var_.notify_one();  // 通知一个等待消费者
+        }
+        return ret;
+    }
+
+    /**
+     * 批量添加元素, 整批只加锁一次, 共用一个截止时间
+     * 返回每个元素是否入队
+     */
+    std::vector<bool> push_batch(std::vector<T> items, int timeout_ms = -1) {
+        std::vector<bool> accepted(items.size(), false);
+        std::vector<T> evicted;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto deadline = get_deadline(timeout_ms);
+            for (size_t i = 0; i < items.size(); i++) {
+                accepted[i] = enqueue_locked(items[i], lock, timeout_ms, deadline, evicted);
+            }
+        }
+        cond_var_.notify_all();
+        return accepted;
+    }
+
     /**
      * 阻塞取出队列元素
      */
     PopResult<T> pop(int timeout_ms = -1) {  // -1表示无限等待
         std::unique_lock<std::mutex> lock(mutex_);
         
-        auto timeout = (timeout_ms == -1) ? 
-                      std::chrono::milliseconds::max() : 
-                      std::chrono::milliseconds(timeout_ms);
-
-        if (!cond_var_.wait_for(lock, timeout, [this] { return !queue_.empty() || stop_; })) {
+        auto wait_predicate = [this] { return !queue_.empty() || stop_; };
+        if (timeout_ms == -1) {
+            cond_var_.wait(lock, wait_predicate);
+        } else if (!cond_var_.wait_for(lock, std::chrono::milliseconds(timeout_ms), wait_predicate)) {
             return PopResult<T>(std::nullopt, stop_);
         }
         // 可能非空或终止
         if (stop_) {
             return PopResult<T>(std::nullopt, true);
         }
-        T item = queue_.front();
+        T item = std::move(queue_.front());
         queue_.pop();
-        return PopResult<T>(std::make_optional(item), false);
+        bytes_ -= item_size(item);
+        lock.unlock();
+        cond_var_.notify_all();  // 唤醒等待空间的生产者
+        return PopResult<T>(std::make_optional(std::move(item)), false);
     }
 
     /**
      * 非阻塞尝试获取队列元素 并不检查队列是否终止
      */
     PopResult<T> try_pop() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
         if (queue_.empty()) return PopResult<T>(std::nullopt, stop_);
-        T item = queue_.front();
+        T item = std::move(queue_.front());
         queue_.pop();
-        return PopResult<T>(std::make_optional(item), stop_);
+        bytes_ -= item_size(item);
+        bool stopped = stop_;
+        lock.unlock();
+        cond_var_.notify_all();  // 唤醒等待空间的生产者
+        return PopResult<T>(std::make_optional(std::move(item)), stopped);
     }
 
     void stop() {
@@ -106,11 +200,97 @@ public:
         return max_size_;
     }
 
+    void set_policy(OverflowPolicy policy) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy_ = policy;
+    }
+
+    OverflowPolicy policy() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return policy_;
+    }
+
+    /**
+     * 入队与丢弃计数, 丢弃包括被拒绝的新元素和被挤出的旧元素
+     */
+    uint64_t accepted_count() const {
+        return accepted_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t dropped_count() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
 private:
-    std::chrono::milliseconds get_timeout(int timeout_ms) const {
-        return (timeout_ms == -1) ? 
-            std::chrono::milliseconds::max() : 
-            std::chrono::milliseconds(timeout_ms);
+    std::chrono::steady_clock::time_point get_deadline(int timeout_ms) const {
+        auto now = std::chrono::steady_clock::now();
+        return (timeout_ms == -1) ? now : now + std::chrono::milliseconds(timeout_ms);
+    }
+
+    size_t item_size(const T& item) const {
+        return sizer_ ? sizer_(item) : 0;
+    }
+
+    /**
+     * 放入 item_bytes 字节的元素后是否超过数量或字节上限
+     */
+    bool is_full(size_t item_bytes = 0) const {
+        if (queue_.size() >= static_cast<size_t>(max_size_)) {
+            return true;
+        }
+        return max_bytes_ > 0 && !queue_.empty() && bytes_ + item_bytes > max_bytes_;
+    }
+
+    void evict_front(std::vector<T>& evicted) {
+        bytes_ -= item_size(queue_.front());
+        evicted.push_back(std::move(queue_.front()));
+        queue_.pop();
+        dropped_++;
+    }
+
+    /**
+     * 持锁状态下按策略入队
+     */
+    bool enqueue_locked(T& item, std::unique_lock<std::mutex>& lock, int timeout_ms, 
+                        std::chrono::steady_clock::time_point deadline, std::vector<T>& evicted) {
+        size_t item_bytes = item_size(item);
+        auto wait_predicate = [this, item_bytes] { 
+            return stop_ || !is_full(item_bytes); 
+        };
+        if (!stop_) {
+            switch (policy_) {
+                case OverflowPolicy::Block:
+                    if (!wait_predicate()) {
+                        cond_var_.notify_all();  // 先唤醒消费者取走已入队的元素
+                        if (timeout_ms == -1) {
+                            cond_var_.wait(lock, wait_predicate);
+                        } else {
+                            cond_var_.wait_until(lock, deadline, wait_predicate);
+                        }
+                    }
+                    break;
+                case OverflowPolicy::DropNewest:
+                    break;
+                case OverflowPolicy::DropOldest:
+                    while (is_full(item_bytes)) {
+                        evict_front(evicted);
+                    }
+                    break;
+                case OverflowPolicy::LatestOnly:
+                    while (!queue_.empty()) {
+                        evict_front(evicted);
+                    }
+                    break;
+            }
+        }
+        if (stop_ || is_full(item_bytes)) {
+            dropped_++;
+            return false;
+        }
+        bytes_ += item_bytes;
+        queue_.push(std::move(item));
+        accepted_++;
+        return true;
     }
 
 
@@ -120,6 +300,12 @@ private:
     std::queue<T> queue_;
     bool stop_ = false;  // 停止标志
     int max_size_ = 10;  // 默认大小
+    OverflowPolicy policy_ = OverflowPolicy::Block;
+    size_t max_bytes_ = 0;  // 字节上限, 0 表示不限制
+    size_t bytes_ = 0;
+    std::function<size_t(const T&)> sizer_;
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> dropped_{0};
 
 };
 
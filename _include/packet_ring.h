@@ -0,0 +1,59 @@
+#ifndef _PACKET_RING_H_
+#define _PACKET_RING_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "packet_sink.h"
+
+
+/**
+ * 最近编码包的内存环形缓冲, 用于事件片段导出
+ * 只保存包的引用 (与写出共享数据), 按 GOP 整组淘汰, 缓冲区总是从关键帧开始
+ * 保留时长至少为 seconds, 超出 max_bytes (0 表示不限制) 时提前淘汰最旧的 GOP
+ * 导出直接复制包到新文件, 不重新编码
+ */
+class PacketRing : public PacketSink {
+public:
+    PacketRing(double seconds, size_t max_bytes = 0);
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+public:
+    void set_stream(const SegmentStream& stream) override;
+    void write(const AVPacket* pkt, int64_t capture_us) override;
+    void close() override;  // 唤醒等待中的导出
+    int export_clip(int64_t start_us, int64_t end_us, const std::string& path, const std::string& container);
+    size_t bytes() const;
+
+private:
+    struct Entry {
+        AVPacketPtr pkt;
+        int64_t capture_us;
+        std::shared_ptr<const SegmentStream> stream;
+    };
+
+    void evict();
+
+private:
+    static constexpr int64_t EXPORT_GRACE_US = 500 * 1000;  // 片段结束后等待编码输出的最长时间
+
+    int64_t window_us_;
+    size_t max_bytes_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Entry> entries_;  // 解码顺序, 第一个总是关键帧
+    size_t bytes_ = 0;
+    int64_t newest_us_ = INT64_MIN;  // 已加入包的最晚采集时刻
+    bool closed_ = false;
+    std::shared_ptr<const SegmentStream> stream_;
+};
+
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef _PACKET_SINK_H_
+#define _PACKET_SINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_segment_writer.h"
+#include "frame_queue.h"
+#include "segment_writer.h"
+
+
+/**
+ * 编码包的其他输出 (推流、回调、内存缓冲), 与分段文件共用同一次编码
+ * 均由编码线程调用, 实现不得阻塞编码
+ */
+class PacketSink {
+public:
+    virtual ~PacketSink() = default;
+
+    virtual void set_stream(const SegmentStream& stream) = 0;  // 之后的包使用该流参数
+    virtual void write(const AVPacket* pkt, int64_t capture_us) = 0;  // 只读, capture_us 为入队时刻 (get_time_us)
+    virtual void close() = 0;  // 不会再有新包
+};
+
+
+/**
+ * 在独立线程中处理编码包的输出
+ * 待处理的包超过 max_pending 时丢弃, 并一直丢弃到下一个关键帧, 慢速的接收方只影响自身
+ * 派生类构造完成后调用 start, 析构时先调用 close
+ */
+class ThreadedPacketSink : public PacketSink {
+public:
+    explicit ThreadedPacketSink(int max_pending);
+    ~ThreadedPacketSink() override;
+
+    ThreadedPacketSink(const ThreadedPacketSink&) = delete;
+    ThreadedPacketSink& operator=(const ThreadedPacketSink&) = delete;
+
+    void set_stream(const SegmentStream& stream) override;
+    void write(const AVPacket* pkt, int64_t capture_us) override;
+    void close() override;  // 处理完已提交的包后结束线程
+    uint64_t dropped() const { return dropped_.load(); }
+
+protected:
+    void start();
+    virtual void on_packet(AVPacketPtr pkt, int64_t capture_us, const SegmentStream& stream) = 0;
+    virtual void on_close() {}
+
+private:
+    struct Item {
+        AVPacketPtr pkt;
+        int64_t capture_us;
+        std::shared_ptr<const SegmentStream> stream;
+    };
+
+    void sink_thread();
+
+private:
+    FrameQueue<Item> queue_;
+    std::thread thread_;
+    std::shared_ptr<const SegmentStream> stream_;  // 仅编码线程访问
+    bool skipping_ = false;  // 丢弃到下一个关键帧, 仅编码线程访问
+    std::atomic<uint64_t> dropped_{0};
+};
+
+
+/**
+ * 经 libavformat 推流: rtmp:// 为 FLV, rtsp:// 为 RTSP, srt:// 与 udp:// 为 MPEG-TS, 其他由地址推断
+ * 连接从关键帧开始, 时间戳从 0 开始; 编码器没有全局头时从第一个关键帧提取参数集
+ * 写出失败或编码参数改变后断开, 间隔 RECONNECT_INTERVAL_US 后在关键帧处重新连接
+ * 未指定 rw_timeout 时读写超时为 RW_TIMEOUT_US; close 中断阻塞中的连接与写出, 不再等待接收方
+ */
+class StreamSink : public ThreadedPacketSink {
+public:
+    StreamSink(const std::string& url, const std::string& format = "",
+               const std::map<std::string, std::string>& options = {});
+    ~StreamSink() override;
+
+    void close() override;
+
+protected:
+    void on_packet(AVPacketPtr pkt, int64_t capture_us, const SegmentStream& stream) override;
+    void on_close() override;
+
+private:
+    int connect(const SegmentStream& stream, const AVPacket* pkt);
+    void disconnect();
+    static int interrupted(void* opaque);  // libavformat 阻塞调用中轮询, 返回非 0 时中止
+
+private:
+    static const int MAX_PENDING = 256;
+    static constexpr int64_t RECONNECT_INTERVAL_US = 2 * 1000 * 1000;
+    static constexpr int64_t RW_TIMEOUT_US = 5 * 1000 * 1000;  // 接收方停止响应时单次读写的最长等待
+
+    std::string url_;
+    std::string format_;
+    std::map<std::string, std::string> options_;
+    AVFormatContext* fmt_ctx_ = nullptr;
+    bool header_written_ = false;
+    std::vector<uint8_t> extradata_;  // 连接时编码器的全局头, 改变后重新连接
+    int64_t ts_offset_ = 0;
+    int64_t retry_us_ = 0;
+    std::atomic<bool> stopping_{false};
+};
+
+
+/**
+ * 把编码包交给回调, 包的所有权随之转移, 数据不复制
+ * capture_us 为系统时钟 (微秒), 与分段目录一致
+ */
+using PacketCallback = std::function<void(AVPacketPtr pkt, int64_t capture_us)>;
+
+class CallbackSink : public ThreadedPacketSink {
+public:
+    explicit CallbackSink(PacketCallback callback, int max_pending = MAX_PENDING);
+    ~CallbackSink() override;
+
+protected:
+    void on_packet(AVPacketPtr pkt, int64_t capture_us, const SegmentStream& stream) override;
+
+private:
+    static const int MAX_PENDING = 256;
+    PacketCallback callback_;
+};
+
+
+#endif
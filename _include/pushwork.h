@@ -13,38 +13,139 @@
 #include <filesystem>
 
 #include "encoder.h"
+#include "frame_converter.h"
 #include "frame_queue.h"
+#include "spsc_queue.h"
+#include "frame_item.h"
+#include "frame_pool.h"
+#include "spill_file.h"
+#include "speed_controller.h"
+#include "segment_encoder_pool.h"
+#include "scene_detector.h"
+#include "rendition.h"
+#include "retention_manager.h"
+#include "packet_ring.h"
+#include "packet_sink.h"
+
+
+/**
+ * 运行统计, 供 Python 查询
+ */
+struct PushStats {
+    uint64_t accepted = 0;   // 入队帧数
+    uint64_t dropped = 0;    // 因队列满或停止被丢弃的帧数
+    size_t queue_size = 0;   // 当前队列长度
+    size_t queue_bytes = 0;  // 当前队列占用字节数 (设置字节上限后统计)
+    uint64_t spilled = 0;    // 写入溢出文件的帧数
+    size_t spill_pending = 0;  // 溢出文件中待读回的帧数
+    LatencyStats latency;      // 入队到编码数据写出的延迟
+    LatencyStats convert_time;  // 每帧转换阶段的耗时
+    LatencyStats encode_time;   // 每帧送入编码器的耗时
+    uint64_t encoded_frames = 0;  // 已写出的编码帧数
+    uint64_t encoded_bytes = 0;   // 已写出的编码字节数
+    uint64_t static_skipped = 0;  // 判定为静止画面而跳过的帧数
+    std::vector<RenditionStats> renditions;  // 各路缩小分辨率输出
+    int64_t storage_bytes = 0;    // 配额内保留的分段总字节数
+    uint64_t segments_deleted = 0;  // 超出配额被删除的分段数
+    size_t clip_buffer_bytes = 0;   // 片段导出缓冲中的编码字节数
+    uint64_t output_dropped = 0;    // 推流与回调输出因处理不及丢弃的包数
+};
 
 
 class PushWork {
 public:
-    PushWork(int queue_size, int width, int height);
+    PushWork(int queue_size, int width, int height, const std::string& pix_fmt = "bgr24");
     ~PushWork();
 
 public:
     int init();  // 开启线程
-    bool put_data(cv::Mat mat);
+    bool put_data(cv::Mat mat, std::shared_ptr<void> holder = nullptr, std::vector<RoiRect> rois = {});
+    std::vector<bool> put_batch(const std::vector<cv::Mat>& mats, std::shared_ptr<void> holder = nullptr);
     void stop(int timeout_seconds);
+    void set_overflow_policy(OverflowPolicy policy);
+    void set_byte_budget(size_t max_bytes);
+    int set_convert_threads(int num_threads);
+    void set_simd_convert(bool enable);
+    int set_encoder_settings(const EncoderSettings& settings);
+    EncoderSettings encoder_settings() const { return encoder_.settings(); }
+    int set_adaptive_speed(bool enable);
+    int set_parallel_segments(int workers);
+    int set_static_skip(StaticSkipMode mode, double threshold = 1.0, int max_skip = 0);
+    int add_rendition(int width, int height, std::optional<EncoderSettings> settings = std::nullopt);
+    std::vector<std::string> completed_segments();
+    int set_catalog(const std::string& path);
+    int set_retention(const std::string& directory, int64_t max_bytes, double max_age_seconds = 0);
+    std::optional<CatalogEntry> lookup(int64_t capture_us);
+    int set_clip_buffer(double seconds, size_t max_bytes = 0);
+    int export_clip(double pre_seconds, double post_seconds, const std::string& path);
+    int add_stream_output(const std::string& url, const std::string& format = "",
+                          const std::map<std::string, std::string>& options = {});
+    int add_packet_callback(PacketCallback callback);
+    int enable_spill(const std::string& path, size_t capacity_bytes);
+    PushStats stats() const;
+
+    // 预分配缓冲池: 调用方写入 acquire_buffer 取得的槽位后 commit_buffer 入队
+    int init_buffer_pool(int count);
+    int acquire_buffer(int timeout_ms = -1);
+    bool commit_buffer(int slot, std::vector<RoiRect> rois = {});
+    void release_buffer(int slot);
+    std::shared_ptr<FramePool> buffer_pool() const { return pool_; }
     void set_finish();
 
 private:
-    void consumer_thread();
+    void consumer_thread();  // 转换阶段
+    void encode_thread();  // 编码阶段
+    double record_time(LatencyStats& stage, int64_t start_us);  // 记录一帧在某阶段的耗时
     void init_params();
+    bool enqueue(FrameItem item);
+    void refill_from_spill();
+    SegmentListener segment_listener() const;
 
 
 private:
-    int fps = 25;
     std::mutex mtx_;  // 线程运行标志位的互斥量
 
 protected:
     std::thread worker_;
+    std::thread encode_worker_;
     std::atomic<bool> running{true};           // 线程运行标志位
     std::atomic<bool> has_finished_{false};    // 线程是否运行结束
     std::condition_variable cv_;
+    FrameConverter converter_;
     Encoder encoder_;
 
 private:
-    FrameQueue<cv::Mat> queue_;
+    FrameQueue<FrameItem> queue_;
+    // 转换阶段 -> 编码阶段, 容量很小, 只用于两阶段之间的解耦
+    static const int YUV_QUEUE_SIZE = 3;
+    SpscFrameQueue<AVFramePtr> yuv_queue_{YUV_QUEUE_SIZE};
+    bool adaptive_speed_ = false;
+    std::unique_ptr<SpeedController> speed_ctrl_;  // 仅编码线程访问
+    int segment_workers_ = 1;
+    std::unique_ptr<SegmentEncoderPool> segment_pool_;  // 分段并行编码, 为空时使用 encoder_
+
+    // 静止画面检测, 仅转换线程访问
+    StaticSkipMode skip_mode_ = StaticSkipMode::Off;
+    std::unique_ptr<SceneDetector> detector_;
+    std::atomic<uint64_t> static_skipped_{0};
+
+    // 各阶段每帧耗时, 由 stats 读取
+    LatencyStats convert_time_;
+    LatencyStats encode_time_;
+    mutable std::mutex timing_mtx_;
+
+    std::vector<std::unique_ptr<Rendition>> renditions_;  // init 之后不再变化
+    std::shared_ptr<SegmentCatalog> catalog_;
+    std::shared_ptr<RetentionManager> retention_;
+    std::shared_ptr<PacketRing> ring_;
+    std::vector<std::shared_ptr<ThreadedPacketSink>> outputs_;  // 推流与回调输出
+    std::shared_ptr<FramePool> pool_;
+
+    // 溢出暂存: spill_ 非空时新帧必须先进入 spill_, 保证帧序
+    std::unique_ptr<SpillFile> spill_;
+    mutable std::mutex spill_mtx_;
+    std::atomic<uint64_t> spilled_{0};
+    std::atomic<uint64_t> spill_dropped_{0};
     int queue_size;
 };
 
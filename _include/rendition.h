@@ -0,0 +1,68 @@
+#ifndef _RENDITION_H_
+#define _RENDITION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+#include "encoder.h"
+#include "frame_converter.h"
+#include "spsc_queue.h"
+
+
+struct RenditionStats {
+    int width = 0;
+    int height = 0;
+    uint64_t encoded_frames = 0;
+    uint64_t encoded_bytes = 0;
+    uint64_t dropped = 0;  // 队列满被丢弃的帧数
+};
+
+
+/**
+ * 缩小分辨率的附加输出
+ * 直接引用转换后的全分辨率帧, 在独立线程中缩放并编码, 分段文件名带 <宽>x<高> 后缀
+ * 处理不及时丢弃本输出的帧, 不阻塞主输出
+ */
+class Rendition {
+public:
+    Rendition(int src_width, int src_height, AVPixelFormat pix_fmt,
+              int width, int height, const EncoderSettings& settings);
+    ~Rendition();
+
+    Rendition(const Rendition&) = delete;
+    Rendition& operator=(const Rendition&) = delete;
+
+public:
+    int init();
+    void push(const AVFrame* frame);  // 仅限单个线程调用
+    void finish();  // 编码剩余帧后结束线程
+    void set_segment_listener(SegmentListener listener) { encoder_.set_segment_listener(std::move(listener)); }
+    void set_segment_dir(const std::string& dir) { encoder_.set_segment_dir(dir); }  // init 之前调用
+    RenditionStats stats() const;
+
+private:
+    void encode_thread();
+    AVFramePtr scale(const AVFrame* src);
+
+private:
+    static const int QUEUE_SIZE = 3;
+    int src_width_;
+    int src_height_;
+    AVPixelFormat pix_fmt_;
+    int width_;
+    int height_;
+
+    Encoder encoder_;
+    SwsContext* sws_ctx_ = nullptr;
+    SpscFrameQueue<AVFramePtr> queue_{QUEUE_SIZE};
+    std::thread thread_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+
+#endif
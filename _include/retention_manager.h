@@ -0,0 +1,67 @@
+#ifndef _RETENTION_MANAGER_H_
+#define _RETENTION_MANAGER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+/**
+ * 分段文件的存储配额
+ * 编码器每关闭一个分段登记一次 (路径与大小), 增量维护总字节数, 不重复扫描目录;
+ * 分段目录必须显式指定, 也是编码器写出分段的目录; 只登记该目录中的分段
+ * 启动时扫描一次分段目录, 只接管 Encoder::segment_name 格式命名的之前运行留下的分段
+ * 超出字节上限或保留时长的最旧分段在低优先级 (CPU nice 19, I/O idle) 的后台线程中逐个删除,
+ * 两次删除之间间隔 DELETE_INTERVAL_MS, 避免集中删除造成 I/O 抖动
+ */
+class RetentionManager {
+public:
+    RetentionManager(const std::string& directory, int64_t max_bytes, double max_age_seconds);
+    ~RetentionManager();
+
+    RetentionManager(const RetentionManager&) = delete;
+    RetentionManager& operator=(const RetentionManager&) = delete;
+
+public:
+    void start();
+    void stop();
+    void add(const std::string& path, int64_t bytes);  // 分段关闭后调用, 线程安全
+    int64_t total_bytes() const;
+    const std::string& directory() const { return directory_; }  // 分段目录的绝对路径
+    uint64_t deleted() const { return deleted_.load(); }
+
+private:
+    struct Segment {
+        std::string path;
+        int64_t bytes;
+        int64_t closed_us;  // 系统时钟
+    };
+
+    void scan();
+    bool in_directory(const std::string& path) const;
+    void retention_thread();
+    bool over_quota(int64_t now_us) const;
+
+private:
+    static constexpr int DELETE_INTERVAL_MS = 50;
+    static constexpr int CHECK_INTERVAL_MS = 1000;  // 无新分段时按保留时长检查的周期
+
+    std::string directory_;
+    int64_t max_bytes_;
+    int64_t max_age_us_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Segment> segments_;  // 按关闭时刻由旧到新
+    int64_t total_bytes_ = 0;
+    bool running_ = false;
+    std::thread thread_;
+    std::atomic<uint64_t> deleted_{0};
+};
+
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _SCENE_DETECTOR_H_
+#define _SCENE_DETECTOR_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+/**
+ * 两行字节的绝对差之和 (SAD)
+ */
+typedef uint64_t (*SadRowFunc)(const uint8_t* a, const uint8_t* b, size_t n);
+
+uint64_t sad_row_c(const uint8_t* a, const uint8_t* b, size_t n);
+
+/**
+ * 按名称 (c / sse2 / avx2) 取得指定实现, 未编译或 CPU 不支持时返回 nullptr, 供测试使用
+ */
+SadRowFunc find_sad_row(const char* name);
+
+
+/**
+ * 静止画面的处理方式
+ */
+enum class StaticSkipMode {
+    Off,     // 不检测
+    Drop,    // 丢弃静止帧, 时间戳保留间隔
+    Repeat,  // 重复编码上一帧, 编码器几乎全部跳过宏块, 保持恒定帧率
+};
+
+
+/**
+ * 静止画面检测
+ * 每隔 ROW_STEP 行取一行, 与上一个保留帧的对应行计算 SAD (向量化), 平均每字节差值低于阈值视为静止
+ * 与上一个保留帧而不是上一帧比较, 缓慢变化不会被逐帧累积漏检
+ * 只在转换线程中使用
+ */
+class SceneDetector {
+public:
+    SceneDetector(double threshold, int max_skip);
+
+public:
+    bool is_static(const cv::Mat& mat);  // 返回 true 表示可跳过; 否则以该帧作为新的参考帧
+    double last_diff() const { return last_diff_; }
+
+private:
+    void store(const cv::Mat& mat);
+
+private:
+    static const int ROW_STEP = 8;
+    double threshold_;       // 平均每字节差值阈值
+    int max_skip_;           // 连续跳过的最大帧数, 0 表示不限制
+    int skipped_ = 0;        // 当前连续跳过的帧数
+    double last_diff_ = 0;
+
+    std::vector<uint8_t> reference_;  // 参考帧的采样行
+    int rows_ = 0;
+    size_t row_bytes_ = 0;
+};
+
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef _SEGMENT_CATALOG_H_
+#define _SEGMENT_CATALOG_H_
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+
+/**
+ * 时间点查询结果: 不晚于查询时刻的最近关键帧
+ */
+struct CatalogEntry {
+    std::string file;          // 分段文件的绝对路径
+    int64_t offset = -1;       // 关键帧在分段文件中的字节偏移, -1 表示由封装的索引按 pts 定位
+    int64_t pts = 0;           // 关键帧的 pts, 时间基为 1/fps
+    int64_t capture_us = 0;    // 关键帧的采集时刻 (系统时钟, 微秒)
+    int64_t segment_end_us = 0;  // 所在分段最后一帧的采集时刻, 查询时刻晚于它说明落在分段之间的空隙
+};
+
+
+/**
+ * 内存映射的定长记录表, 只追加
+ * 文件头记录条目数, 条目先写入后增加计数, 其他进程以只读方式打开即可看到已完成的条目
+ * 非线程安全, 由调用方加锁
+ */
+class MappedTable {
+public:
+    MappedTable(const std::string& path, uint32_t record_size, bool read_only);
+    ~MappedTable();
+
+    MappedTable(const MappedTable&) = delete;
+    MappedTable& operator=(const MappedTable&) = delete;
+
+public:
+    uint64_t count() const;
+    const uint8_t* record(uint64_t index);  // 其他进程追加后按需重新映射
+    uint8_t* mutable_record(uint64_t index);
+    uint8_t* append();  // 返回新条目的位置, 填写后 commit 使其可见
+    void commit();
+
+private:
+    void map(size_t bytes);
+
+private:
+    static const size_t HEADER_SIZE = 64;
+    std::string path_;
+    uint32_t record_size_;
+    bool read_only_;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t map_bytes_ = 0;
+};
+
+
+/**
+ * 分段目录: 记录每个分段的文件、首尾 pts 与采集时刻, 以及每个关键帧的位置
+ * 由 <path>.segments 与 <path>.keys 两个只追加的内存映射文件组成, 跨进程重启继续追加
+ * 关键帧按采集时刻有序 (时钟回拨时沿用上一个关键帧的时刻), 查询为二分查找
+ */
+class SegmentCatalog {
+public:
+    explicit SegmentCatalog(const std::string& path, bool read_only = false);
+
+    SegmentCatalog(const SegmentCatalog&) = delete;
+    SegmentCatalog& operator=(const SegmentCatalog&) = delete;
+
+public:
+    int begin_segment(const std::string& file, int64_t pts, int64_t capture_us);
+    int add_packet(int64_t pts, int64_t capture_us, bool key, int64_t offset);  // 属于最近开始的分段
+    std::optional<CatalogEntry> lookup(int64_t capture_us);
+    uint64_t segment_count();
+    uint64_t key_count();
+
+private:
+    struct SegmentRecord {
+        char file[256];
+        int64_t first_pts;
+        int64_t last_pts;
+        int64_t first_us;
+        int64_t last_us;
+        uint64_t first_key;
+        uint64_t key_count;
+    };
+
+    struct KeyRecord {
+        int64_t capture_us;
+        int64_t pts;
+        int64_t offset;
+        uint64_t segment;
+    };
+
+    std::mutex mtx_;
+    bool read_only_;
+    MappedTable segments_;
+    MappedTable keys_;
+};
+
+
+#endif
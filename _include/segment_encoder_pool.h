@@ -0,0 +1,77 @@
+#ifndef _SEGMENT_ENCODER_POOL_H_
+#define _SEGMENT_ENCODER_POOL_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "encoder.h"
+#include "frame_converter.h"
+#include "spsc_queue.h"
+
+
+/**
+ * 分段并行编码
+ * 按帧数切分为独立分段 (segment_frames, 或 segment_seconds 按 fps 换算), 整段按轮询分给 N 个 Encoder,
+ * 各自在独立线程中编码并写入各自的文件; 分段在编码前分发, 不支持按大小切分
+ * 分段完成顺序可能与编码顺序不同, 完成结果按分段序号依次上报
+ * 每个工作线程最多缓存一整段图像帧, 内存占用约为 N * 分段帧数
+ */
+class SegmentEncoderPool {
+public:
+    SegmentEncoderPool(int workers, int width, int height, AVPixelFormat pix_fmt, const EncoderSettings& settings);
+    ~SegmentEncoderPool();
+
+    SegmentEncoderPool(const SegmentEncoderPool&) = delete;
+    SegmentEncoderPool& operator=(const SegmentEncoderPool&) = delete;
+
+public:
+    int init();
+    void set_segment_listener(const SegmentListener& listener);  // init 之前调用
+    void set_segment_dir(const std::string& dir);  // init 之前调用
+    bool push(AVFramePtr frame);  // 仅限单个分发线程调用
+    void finish();  // 编码剩余帧, 关闭所有分段并等待工作线程退出
+    std::vector<std::string> take_completed();  // 取出按序完成的分段文件
+    void collect(LatencyStats& latency, LatencyStats& encode_time, uint64_t& frames, uint64_t& bytes) const;  // 汇总各编码器的统计
+
+private:
+    struct SegmentFrame {
+        AVFramePtr frame;
+        uint64_t segment = 0;
+        std::string filename;  // 非空表示分段的第一帧
+        bool last = false;     // 分段的最后一帧
+    };
+
+    struct Worker {
+        explicit Worker(int queue_size) : queue(queue_size) {}
+        std::unique_ptr<Encoder> encoder;
+        SpscFrameQueue<SegmentFrame> queue;
+        std::thread thread;
+        LatencyStats encode_time;  // 每帧编码耗时
+        mutable std::mutex timing_mtx;
+    };
+
+    void worker_thread(Worker* worker);
+    void complete(uint64_t segment, const std::string& filename);
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    int segment_frames_ = 0;
+
+    // 分发状态, 仅分发线程访问
+    uint64_t segment_ = 0;
+    int frame_in_segment_ = 0;
+
+    // 按序上报
+    std::mutex done_mtx_;
+    std::map<uint64_t, std::string> done_;  // 已完成但前序分段尚未完成
+    uint64_t next_report_ = 0;
+    std::vector<std::string> completed_;
+};
+
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _SEGMENT_WRITER_H_
+#define _SEGMENT_WRITER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include "buffered_file.h"
+
+
+/**
+ * 分段中视频流的参数, 由编码器上下文复制, 编码器重新打开后仍然有效
+ */
+struct SegmentStream {
+    std::shared_ptr<AVCodecParameters> par;
+    AVRational time_base = {1, 1};
+    AVRational frame_rate = {0, 1};
+
+    static SegmentStream from_context(const AVCodecContext* codec_ctx);
+};
+
+// 分段关闭完成时的通知: 分段文件的绝对路径与磁盘上的文件大小
+using SegmentListener = std::function<void(const std::string& path, int64_t bytes)>;
+
+
+/**
+ * 分段文件的写出方式
+ * 编码输出包的时间基为 SegmentStream::time_base, 由实现负责换算
+ */
+class SegmentWriter {
+public:
+    virtual ~SegmentWriter() = default;
+
+    virtual int open(const std::string& path, const SegmentStream& stream) = 0;
+    virtual int write(AVPacket* pkt) = 0;  // 可取走 pkt 的数据, 调用后 pkt 的内容不再有效
+    virtual void flush() = 0;  // 已写出的数据立即落盘 (交给内核)
+    virtual int close() = 0;
+    virtual int wait() { return 0; }  // 等待已提交的写出完成, 返回期间是否出错
+    virtual void prepare_next() {}  // 预先创建下一个分段的文件, 由 AsyncSegmentWriter 在 I/O 线程空闲时调用
+    virtual bool is_open() const = 0;
+    virtual const char* extension() const = 0;  // 为空时使用编码器的裸码流扩展名
+    virtual bool global_header() const = 0;  // 编码器是否需要输出全局头 (extradata)
+    // 文件关闭完成后在执行关闭的线程中调用, 打开分段之前设置
+    virtual void set_close_listener(SegmentListener listener) { close_listener_ = std::move(listener); }
+
+protected:
+    void notify_closed(const std::string& path);
+
+private:
+    SegmentListener close_listener_;
+};
+
+
+/**
+ * 裸码流 (H.264/HEVC Annex-B, AV1 OBU), 不含时间戳与索引
+ */
+class RawSegmentWriter : public SegmentWriter {
+public:
+    explicit RawSegmentWriter(const WriterOptions& options);
+
+    int open(const std::string& path, const SegmentStream& stream) override;
+    int write(AVPacket* pkt) override;
+    void flush() override;
+    int close() override;
+    void prepare_next() override { file_.prepare_spare(); }
+    bool is_open() const override { return file_.is_open(); }
+    const char* extension() const override { return nullptr; }
+    bool global_header() const override { return false; }
+
+private:
+    BufferedFile file_;
+    std::string path_;
+};
+
+
+/**
+ * 经 libavformat 封装为分片 MP4 或 Matroska, 带时间戳、帧率与关键帧索引
+ * MP4 每个关键帧开始一个分片, 写入中断时已完成的分片仍可播放; 关闭时写入 mfra 索引
+ * Matroska 关闭时写入 Cues 索引
+ * 通过自定义 AVIOContext 写入 BufferedFile, 与裸码流共用缓冲与落盘策略
+ */
+class ContainerSegmentWriter : public SegmentWriter {
+public:
+    ContainerSegmentWriter(const std::string& container, const WriterOptions& options);
+    ~ContainerSegmentWriter() override;
+
+    int open(const std::string& path, const SegmentStream& stream) override;
+    int write(AVPacket* pkt) override;
+    void flush() override;
+    int close() override;
+    void prepare_next() override { file_.prepare_spare(); }
+    bool is_open() const override { return fmt_ctx_ != nullptr; }
+    const char* extension() const override;
+    bool global_header() const override { return true; }
+
+private:
+    std::string container_;  // mp4 / mkv
+    AVFormatContext* fmt_ctx_ = nullptr;
+    bool header_written_ = false;
+    AVRational codec_time_base_ = {1, 1};
+    BufferedFile file_;
+    std::string path_;
+};
+
+
+/**
+ * 封装名称是否受支持: raw / mp4 / mkv
+ */
+bool segment_container_supported(const std::string& container);
+
+
+/**
+ * 按封装名称创建: raw / mp4 / mkv, 不支持返回 nullptr
+ */
+std::unique_ptr<SegmentWriter> make_segment_writer(const std::string& container,
+                                                   const WriterOptions& options = WriterOptions());
+
+
+#endif
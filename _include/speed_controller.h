@@ -0,0 +1,46 @@
+#ifndef _SPEED_CONTROLLER_H_
+#define _SPEED_CONTROLLER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+
+#include "encoder.h"
+
+
+/**
+ * 编码速度自适应控制
+ * 编码线程逐帧记录编码耗时与输入队列深度, 在分段边界统计本段负载:
+ *   过载 (平均耗时接近帧间隔或队列堆积) 时先换更快的 preset, 已是最快则提高 CRF
+ *   空闲时按相反顺序逐级恢复, 不超过初始设置的 preset 与 CRF
+ * 非线程安全, 只在编码线程中使用
+ */
+class SpeedController {
+public:
+    explicit SpeedController(const EncoderSettings& base);
+
+public:
+    void record(int64_t cost_ms, size_t queue_depth);
+    // 分段边界调用, 需要调整时返回新的编码参数
+    std::optional<EncoderSettings> update(const EncoderSettings& current, size_t queue_capacity);
+
+private:
+    EncoderSettings base_;
+    int base_preset_ = -1;     // 初始 preset 在档位表中的位置, -1 表示不在表中, 不调整 preset
+    double base_crf_ = 23;     // 初始 CRF, 未设置时取编码器默认值
+    double max_crf_ = 35;      // CRF 上限, 取决于编码器
+
+    // 本段统计
+    int64_t total_cost_ms_ = 0;
+    size_t max_depth_ = 0;
+    int frames_ = 0;
+
+    static constexpr double OVERLOAD_RATIO = 0.9;   // 平均耗时超过帧间隔的比例视为过载
+    static constexpr double IDLE_RATIO = 0.5;       // 平均耗时低于帧间隔的比例视为空闲
+    static constexpr double OVERLOAD_DEPTH = 0.5;   // 队列深度超过容量的比例视为堆积
+    static constexpr double IDLE_DEPTH = 0.1;
+    static constexpr double CRF_STEP = 2;
+};
+
+
+#endif
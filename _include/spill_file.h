@@ -0,0 +1,53 @@
+#ifndef _SPILLFILE_H_
+#define _SPILLFILE_H_
+
+#include <deque>
+#include <string>
+#include <optional>
+#include <cstdint>
+
+#include "frame_item.h"
+
+
+/**
+ * 队列溢出时的磁盘暂存区
+ * 基于内存映射文件的环形缓冲, 按写入顺序读回; 文件创建后即删除, 进程退出自动回收
+ * 非线程安全, 由调用方加锁
+ */
+class SpillFile {
+public:
+    SpillFile(const std::string& path, size_t capacity);
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+public:
+    bool write(const FrameItem& item);  // 空间不足返回 false
+    std::optional<FrameItem> read();    // 取出最早写入的帧
+    size_t front_bytes() const;
+
+    bool empty() const { return records_.empty(); }
+    size_t count() const { return records_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Record {
+        size_t offset;
+        size_t bytes;
+        int rows;
+        int cols;
+        int type;
+        int64_t enqueue_us;
+        std::vector<RoiRect> rois;
+    };
+
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t capacity_ = 0;
+    size_t tail_ = 0;  // 下一次写入位置
+    std::deque<Record> records_;
+};
+
+
+#endif
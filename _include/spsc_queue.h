@@ -0,0 +1,193 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+
+#include "frame_queue.h"
+
+
+/**
+ * 单生产者单消费者无锁环形队列
+ * 接口与 FrameQueue 一致; 元素以移动方式传递, 只允许一个线程 push、一个线程 pop
+ * 等待时先自旋, 超过自旋次数后挂起在条件变量上
+ */
+template<typename T>
+class SpscFrameQueue {
+
+public:
+    SpscFrameQueue(int max_size) : max_size_(max_size) {
+        if (max_size <= 0) {
+            throw std::invalid_argument("max_size must be greater than 0");
+        }
+        size_t capacity = 1;
+        while (capacity < static_cast<size_t>(max_size)) {
+            capacity <<= 1;
+        }
+        mask_ = capacity - 1;
+        slots_.resize(capacity);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    /**
+     * 添加元素, 仅限生产者线程调用
+     * timeout = -1 表示无限等待
+     */
+    bool push(T item, int timeout_ms = -1) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        auto has_space = [this, tail] {
+            if (tail - cached_head_ < max_size_) {
+                return true;
+            }
+            cached_head_ = head_.load(std::memory_order_seq_cst);
+            return tail - cached_head_ < max_size_;
+        };
+        if (!wait(has_space, timeout_ms)) {
+            return false;
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail & mask_].emplace(std::move(item));
+        tail_.store(tail + 1, std::memory_order_seq_cst);
+        wake();
+        return true;
+    }
+
+    /**
+     * 阻塞取出队列元素, 仅限消费者线程调用
+     */
+    PopResult<T> pop(int timeout_ms = -1) {  // -1表示无限等待
+        size_t head = head_.load(std::memory_order_relaxed);
+        auto has_item = [this, head] {
+            if (cached_tail_ != head) {
+                return true;
+            }
+            cached_tail_ = tail_.load(std::memory_order_seq_cst);
+            return cached_tail_ != head;
+        };
+        if (!wait(has_item, timeout_ms)) {
+            return PopResult<T>(std::nullopt, stop_.load(std::memory_order_acquire));
+        }
+        // 可能非空或终止
+        if (stop_.load(std::memory_order_acquire)) {
+            return PopResult<T>(std::nullopt, true);
+        }
+        return PopResult<T>(take(head), false);
+    }
+
+    /**
+     * 非阻塞尝试获取队列元素 并不检查队列是否终止
+     */
+    PopResult<T> try_pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        bool stopped = stop_.load(std::memory_order_acquire);
+        if (cached_tail_ == head) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (cached_tail_ == head) {
+                return PopResult<T>(std::nullopt, stopped);
+            }
+        }
+        return PopResult<T>(take(head), stopped);
+    }
+
+    void stop() {
+        stop_.store(true, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_all();
+    }
+
+    /**
+     * 查询最大容量
+     */
+    size_t capacity() const {
+        return max_size_;
+    }
+
+private:
+    std::optional<T> take(size_t head) {
+        std::optional<T>& slot = slots_[head & mask_];
+        std::optional<T> item(std::move(slot));
+        slot.reset();
+        head_.store(head + 1, std::memory_order_seq_cst);
+        wake();
+        return item;
+    }
+
+    /**
+     * 等待 ready 成立或队列终止; 先自旋, 再挂起
+     * 挂起前登记 waiters_, 对端发布后检查 waiters_ 决定是否唤醒, 两侧均为 seq_cst 保证不丢失唤醒
+     */
+    template<typename Pred>
+    bool wait(Pred ready, int timeout_ms) {
+        auto is_ready = [this, &ready] {
+            return ready() || stop_.load(std::memory_order_seq_cst);
+        };
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            if (is_ready()) {
+                return true;
+            }
+            if (i >= SPIN_COUNT / 2) {
+                std::this_thread::yield();
+            }
+        }
+        if (timeout_ms == 0) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        bool ret = true;
+        if (timeout_ms == -1) {
+            park_cv_.wait(lock, is_ready);
+        } else {
+            ret = park_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), is_ready);
+        }
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        return ret;
+    }
+
+    void wake() {
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            park_cv_.notify_all();
+        }
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr int SPIN_COUNT = 256;  // 挂起前的自旋次数
+
+    // 消费者独占
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;  // 消费者缓存的 tail_, 减少跨核读取
+    // 生产者独占
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;  // 生产者缓存的 head_
+
+    alignas(CACHE_LINE) std::atomic<bool> stop_{false};  // 停止标志
+    std::atomic<int> waiters_{0};  // 挂起的线程数
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+
+    std::vector<std::optional<T>> slots_;
+    size_t mask_ = 0;
+    size_t max_size_ = 10;
+};
+
+
+#endif
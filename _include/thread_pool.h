@@ -0,0 +1,126 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+
+
+/**
+ * 固定大小的并行任务池
+ * run 将 [0, count) 的任务分发给工作线程, 调用线程同时参与执行, 全部完成后返回
+ * run 同一时刻只允许一个线程调用, task 不应抛出异常
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads) {
+        if (num_threads <= 0) {
+            throw std::invalid_argument("num_threads must be greater than 0");
+        }
+        for (int i = 0; i < num_threads - 1; i++) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_var_.notify_all();
+        for (auto& t : workers_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * 并行执行 task(0) ... task(count - 1)
+     */
+    void run(int count, const std::function<void(int)>& task) {
+        if (count <= 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            count_ = count;
+            next_ = 0;
+            pending_ = count;
+            generation_++;
+        }
+        cond_var_.notify_all();
+        execute();
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_var_.wait(lock, [this] { return pending_ == 0; });
+        task_ = nullptr;
+    }
+
+    int size() const {
+        return static_cast<int>(workers_.size()) + 1;
+    }
+
+private:
+    void worker_loop() {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_var_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            execute();
+        }
+    }
+
+    /**
+     * 领取并执行任务, 直到本轮任务分发完毕
+     */
+    void execute() {
+        while (true) {
+            int index;
+            const std::function<void(int)>* task;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!task_ || next_ >= count_) {
+                    return;
+                }
+                index = next_++;
+                task = task_;
+            }
+            (*task)(index);
+            bool finished;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                finished = (--pending_ == 0);
+            }
+            if (finished) {
+                done_var_.notify_one();
+            }
+        }
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cond_var_;   // 通知工作线程有新任务
+    std::condition_variable done_var_;   // 通知调用线程任务完成
+    const std::function<void(int)>* task_ = nullptr;
+    int count_ = 0;
+    int next_ = 0;
+    int pending_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+
+#endif
@@ -5,5 +5,7 @@
 #include <chrono>
 
 int64_t get_time_ms();
+int64_t get_time_us();  // 单调时钟, 用于计算时间间隔
+int64_t get_wall_time_us();  // 系统时钟, 微秒
 
 #endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+#include "codec_backend.h"
+#include "encoder.h"
+
+
+/**
+ * 各编码器后端对比: 用同一段合成的 I420 片段编码, 输出编码帧率与平均每帧字节数
+ * 编码参数取 EncoderSettings 默认值 (可指定 preset), 经 CodecBackend 换算, 与 Encoder 的打开方式一致
+ * 本地 FFmpeg 未编译的编码器跳过
+ * 用法: bench_codec [宽] [高] [帧数] [preset]
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static const char* CODECS[] = {"libx264", "libx265", "libsvtav1", "libaom-av1"};
+
+
+/**
+ * 合成片段: 平移的渐变背景加上移动的方块, 帧间既有全局运动又有局部变化
+ */
+static std::vector<AVFrame*> make_clip(int width, int height, int frames) {
+    std::vector<AVFrame*> clip;
+    for (int n = 0; n < frames; n++) {
+        AVFrame* frame = av_frame_alloc();
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width = width;
+        frame->height = height;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            fprintf(stderr, "av_frame_get_buffer failed\n");
+            exit(1);
+        }
+        int box = n * 7 % std::max(1, width - 64);
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = frame->data[0] + y * frame->linesize[0];
+            for (int x = 0; x < width; x++) {
+                bool inside = x >= box && x < box + 64 && y >= height / 3 && y < height / 3 + 64;
+                row[x] = inside ? 235 : static_cast<uint8_t>((x + y + n * 2) & 0xff);
+            }
+        }
+        for (int plane = 1; plane < 3; plane++) {
+            for (int y = 0; y < (height + 1) / 2; y++) {
+                uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+                for (int x = 0; x < (width + 1) / 2; x++) {
+                    row[x] = static_cast<uint8_t>(128 + ((x * plane + y + n) & 0x1f) - 16);
+                }
+            }
+        }
+        frame->pts = n;
+        clip.push_back(frame);
+    }
+    return clip;
+}
+
+
+/**
+ * 编码整个片段并冲刷编码器, 返回 0 表示成功
+ */
+static int encode_clip(const CodecBackend* backend, const AVCodec* codec, const EncoderSettings& settings,
+                       const std::vector<AVFrame*>& clip, double& seconds, int64_t& bytes, int& packets) {
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    AVPacket* pkt = av_packet_alloc();
+    if (!ctx || !pkt) {
+        fprintf(stderr, "allocate codec context failed\n");
+        return -1;
+    }
+    ctx->width = clip[0]->width;
+    ctx->height = clip[0]->height;
+    ctx->time_base = (AVRational){1, settings.fps};
+    ctx->framerate = (AVRational){settings.fps, 1};
+    ctx->gop_size = settings.gop;
+    ctx->max_b_frames = settings.bframes;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->thread_count = settings.threads;
+    AVDictionary* opts = nullptr;
+    backend->apply(settings, ctx, &opts);
+    int ret = avcodec_open2(ctx, codec, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        fprintf(stderr, "%s: avcodec_open2 failed: %d\n", backend->name, ret);
+        av_packet_free(&pkt);
+        avcodec_free_context(&ctx);
+        return -1;
+    }
+
+    bytes = 0;
+    packets = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i <= clip.size() && ret >= 0; i++) {
+        ret = avcodec_send_frame(ctx, i < clip.size() ? clip[i] : nullptr);
+        while (ret >= 0) {
+            ret = avcodec_receive_packet(ctx, pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                ret = 0;
+                break;
+            }
+            if (ret >= 0) {
+                bytes += pkt->size;
+                packets++;
+                av_packet_unref(pkt);
+            }
+        }
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (ret < 0) {
+        fprintf(stderr, "%s: encode failed: %d\n", backend->name, ret);
+    }
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    return ret < 0 ? -1 : 0;
+}
+
+
+int main(int argc, char** argv) {
+    int width = argc > 1 ? atoi(argv[1]) : 1280;
+    int height = argc > 2 ? atoi(argv[2]) : 720;
+    int frames = argc > 3 ? atoi(argv[3]) : 100;
+    EncoderSettings settings;
+    if (argc > 4) {
+        settings.preset = argv[4];
+    }
+    if (width <= 0 || height <= 0 || frames <= 0) {
+        fprintf(stderr, "usage: %s [width] [height] [frames] [preset]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<AVFrame*> clip = make_clip(width, height, frames);
+    printf("%dx%d, %d frames, preset %s, gop %d\n", width, height, frames, settings.preset.c_str(), settings.gop);
+    for (const char* name : CODECS) {
+        const CodecBackend* backend = find_codec_backend(name);
+        const AVCodec* codec = avcodec_find_encoder_by_name(name);
+        if (!backend || !codec) {
+            printf("%-12s not compiled into ffmpeg, skipped\n", name);
+            continue;
+        }
+        double seconds = 0;
+        int64_t bytes = 0;
+        int packets = 0;
+        if (encode_clip(backend, codec, settings, clip, seconds, bytes, packets) < 0) {
+            continue;
+        }
+        printf("%-12s %8.1f fps  %10.0f bytes/frame  (%d packets)\n",
+               name, frames / seconds, static_cast<double>(bytes) / frames, packets);
+    }
+    for (AVFrame* frame : clip) {
+        av_frame_free(&frame);
+    }
+    return 0;
+}
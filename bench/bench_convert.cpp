@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include "convert_simd.h"
+
+
+/**
+ * BGR24 -> I420 内核吞吐, 按输入 BGR24 字节数计 MB/s
+ * 依次测试标量、SSSE3、AVX2 实现 (CPU 不支持时跳过), 以及被替换的 swscale (SWS_BILINEAR) 作为参照
+ * 用法: bench_convert [宽] [高] [重复次数]
+ */
+
+using Clock = std::chrono::steady_clock;
+
+struct Frame {
+    int width;
+    int height;
+    std::vector<uint8_t> bgr;
+    std::vector<uint8_t> y, u, v;
+
+    Frame(int w, int h) : width(w), height(h), bgr(static_cast<size_t>(w) * h * 3),
+                          y(static_cast<size_t>(w) * h),
+                          u(static_cast<size_t>((w + 1) / 2) * ((h + 1) / 2)),
+                          v(static_cast<size_t>((w + 1) / 2) * ((h + 1) / 2)) {
+    }
+};
+
+
+template<typename Convert>
+static double measure(const Frame& frame, int repeat, Convert&& convert) {
+    convert();  // 预热, 触发缺页与缓存
+    auto start = Clock::now();
+    for (int i = 0; i < repeat; i++) {
+        convert();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(frame.bgr.size()) * repeat / seconds / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+    int width = argc > 1 ? atoi(argv[1]) : 2432;
+    int height = argc > 2 ? atoi(argv[2]) : 2048;
+    int repeat = argc > 3 ? atoi(argv[3]) : 200;
+    if (width <= 0 || height <= 0 || repeat <= 0) {
+        fprintf(stderr, "usage: %s [width] [height] [repeat]\n", argv[0]);
+        return 1;
+    }
+    Frame frame(width, height);
+    std::mt19937 rng(1);
+    for (auto& b : frame.bgr) {
+        b = static_cast<uint8_t>(rng());
+    }
+    int cw = (width + 1) / 2;
+
+    printf("%dx%d BGR24 -> I420, %d frames\n", width, height, repeat);
+    for (const char* name : {"c", "ssse3", "avx2"}) {
+        Bgr24ToI420Func func = find_bgr24_to_i420(name);
+        if (!func) {
+            printf("%-8s not supported by cpu, skipped\n", name);
+            continue;
+        }
+        double rate = measure(frame, repeat, [&] {
+            func(frame.bgr.data(), width * 3, frame.y.data(), width,
+                 frame.u.data(), cw, frame.v.data(), cw, width, height);
+        });
+        printf("%-8s %8.1f MB/s\n", name, rate);
+    }
+
+    SwsContext* ctx = sws_getContext(width, height, AV_PIX_FMT_BGR24, width, height, AV_PIX_FMT_YUV420P,
+                                     SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!ctx) {
+        fprintf(stderr, "sws_getContext failed\n");
+        return 1;
+    }
+    double rate = measure(frame, repeat, [&] {
+        const uint8_t* src[4] = {frame.bgr.data(), nullptr, nullptr, nullptr};
+        int src_stride[4] = {width * 3, 0, 0, 0};
+        uint8_t* dst[4] = {frame.y.data(), frame.u.data(), frame.v.data(), nullptr};
+        int dst_stride[4] = {width, cw, cw, 0};
+        sws_scale(ctx, src, src_stride, 0, height, dst, dst_stride);
+    });
+    sws_freeContext(ctx);
+    printf("%-8s %8.1f MB/s\n", "swscale", rate);
+    return 0;
+}
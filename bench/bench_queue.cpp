@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "frame_queue.h"
+#include "spsc_queue.h"
+
+
+/**
+ * SpscFrameQueue 与 FrameQueue 对比, 按流水线中转换阶段 -> 编码阶段的用法:
+ * 一个生产者、一个消费者, 容量为 YUV_QUEUE_SIZE, 元素为独占指针 (对应 AVFramePtr)
+ *   吞吐: 生产者连续 push, 消费者连续 pop, 统计每秒传递的元素数
+ *   唤醒延迟: 生产者按固定间隔 push, 消费者大部分时间挂起等待, 统计 push 到 pop 返回的时间
+ * 用法: bench_queue [吞吐元素数] [延迟采样数]
+ */
+
+static const int YUV_QUEUE_SIZE = 3;
+
+using Clock = std::chrono::steady_clock;
+
+struct Item {
+    std::unique_ptr<uint8_t[]> data;
+    Clock::time_point pushed;
+};
+
+
+template<typename Queue>
+static double throughput(int count) {
+    Queue queue(YUV_QUEUE_SIZE);
+    auto start = Clock::now();
+    std::thread producer([&queue, count] {
+        for (int i = 0; i < count; i++) {
+            queue.push(Item{nullptr, Clock::now()});
+        }
+    });
+    int received = 0;
+    while (received < count) {
+        if (queue.pop().item.has_value()) {
+            received++;
+        }
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return count / seconds;
+}
+
+
+template<typename Queue>
+static std::vector<double> wakeup_latency(int samples, int interval_us) {
+    Queue queue(YUV_QUEUE_SIZE);
+    std::vector<double> latency;
+    latency.reserve(samples);
+    std::thread consumer([&queue, &latency, samples] {
+        for (int i = 0; i < samples; i++) {
+            PopResult<Item> res = queue.pop();
+            if (!res.item.has_value()) {
+                break;
+            }
+            latency.push_back(std::chrono::duration<double, std::micro>(Clock::now() - res.item->pushed).count());
+        }
+    });
+    for (int i = 0; i < samples; i++) {
+        // 间隔远大于自旋时间, 消费者在 push 时已挂起
+        std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+        queue.push(Item{nullptr, Clock::now()});
+    }
+    consumer.join();
+    std::sort(latency.begin(), latency.end());
+    return latency;
+}
+
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+
+template<typename Queue>
+static void run(const char* name, int count, int samples) {
+    double rate = throughput<Queue>(count);
+    std::vector<double> latency = wakeup_latency<Queue>(samples, 2000);
+    printf("%-16s throughput: %10.0f items/s   wake-up latency: p50 %7.1f us  p99 %7.1f us  max %7.1f us\n",
+           name, rate, percentile(latency, 0.5), percentile(latency, 0.99), latency.empty() ? 0 : latency.back());
+}
+
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int samples = argc > 2 ? atoi(argv[2]) : 1000;
+    if (count <= 0 || samples <= 0) {
+        fprintf(stderr, "usage: %s [items] [latency_samples]\n", argv[0]);
+        return 1;
+    }
+    run<FrameQueue<Item>>("FrameQueue", count, samples);
+    run<SpscFrameQueue<Item>>("SpscFrameQueue", count, samples);
+    return 0;
+}
@@ -24,6 +24,12 @@ if __name__ == "__main__":
 
     queue_size = 10
     worker = compressor.PushWork(queue_size, 2432, 2048)
+
+    # 编码参数需在 init 之前设置
+    settings = compressor.EncoderSettings()
+    settings.preset = "veryfast"
+    settings.crf = 23
+    worker.set_encoder_settings(settings)
     worker.init()
 
     current_index = 0
@@ -44,7 +50,7 @@ if __name__ == "__main__":
             print(f"Warning: Failed to read {path}")
             continue
         
-        worker.put_data(img)
+        worker.put_data(img, copy=False)  # img 每次重新读取, 可直接交给队列
 
         current_index = (current_index + 1) % len(images)
         time.sleep(0.2)
@@ -0,0 +1,146 @@
+
+#include <iostream>
+
+#include "async_segment_writer.h"
+
+
+AsyncSegmentWriter::AsyncSegmentWriter(std::unique_ptr<SegmentWriter> writer) : writer_(std::move(writer)) {
+    queue_.set_byte_budget(MAX_PENDING_BYTES, [](const Command& command) {
+        return command.pkt ? static_cast<size_t>(command.pkt->size) : 0;
+    });
+    thread_ = std::thread(&AsyncSegmentWriter::io_thread, this);
+}
+
+
+AsyncSegmentWriter::~AsyncSegmentWriter() {
+    queue_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    writer_->close();
+}
+
+
+int AsyncSegmentWriter::open(const std::string& path, const SegmentStream& stream) {
+    Command command{Op::Open, path, stream, nullptr};
+    submit(std::move(command));
+    open_ = true;
+    return take_error();
+}
+
+
+/**
+ * 转移包的引用, 不复制数据
+ */
+int AsyncSegmentWriter::write(AVPacket* pkt) {
+    AVPacketPtr ref(av_packet_alloc());
+    if (!ref) {
+        std::cerr << "av_packet_alloc failed" << std::endl;
+        return -1;
+    }
+    av_packet_move_ref(ref.get(), pkt);
+    submit(Command{Op::Write, std::string(), SegmentStream(), std::move(ref)});
+    return take_error();
+}
+
+
+void AsyncSegmentWriter::flush() {
+    submit(Command{Op::Flush, std::string(), SegmentStream(), nullptr});
+}
+
+
+/**
+ * 不等待关闭完成, 关闭失败在之后的调用中返回
+ */
+int AsyncSegmentWriter::close() {
+    if (!open_) {
+        return take_error();
+    }
+    submit(Command{Op::Close, std::string(), SegmentStream(), nullptr});
+    open_ = false;
+    return take_error();
+}
+
+
+/**
+ * I/O 线程执行关闭后由被包装的写出方式通知, 此时文件已完整写出
+ */
+void AsyncSegmentWriter::set_close_listener(SegmentListener listener) {
+    writer_->set_close_listener(std::move(listener));
+}
+
+
+int AsyncSegmentWriter::wait() {
+    std::unique_lock<std::mutex> lock(pending_mtx_);
+    pending_cv_.wait(lock, [this] { return completed_ == submitted_; });
+    lock.unlock();
+    return take_error();
+}
+
+
+void AsyncSegmentWriter::submit(Command command) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        submitted_++;
+    }
+    if (!queue_.push(std::move(command))) {
+        // 仅在析构停止后发生
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        submitted_--;
+    }
+}
+
+
+void AsyncSegmentWriter::execute(Command& command) {
+    int ret = 0;
+    switch (command.op) {
+    case Op::Open:
+        if (writer_->is_open()) {
+            writer_->close();
+        }
+        ret = writer_->open(command.path, command.stream);
+        break;
+    case Op::Write:
+        // 打开失败的分段丢弃其数据, 错误已在打开时报告
+        ret = writer_->is_open() ? writer_->write(command.pkt.get()) : 0;
+        break;
+    case Op::Flush:
+        writer_->flush();
+        break;
+    case Op::Close:
+        ret = writer_->close();
+        break;
+    }
+    if (ret < 0) {
+        failed_ = true;
+    }
+    command.pkt.reset();
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        completed_++;
+    }
+    pending_cv_.notify_all();
+}
+
+
+void AsyncSegmentWriter::io_thread() {
+    bool prepare = false;  // 已打开新的分段, 尚未准备下一个分段的文件
+    while (true) {
+        PopResult<Command> res = prepare ? queue_.try_pop() : queue_.pop();
+        if (!res.item.has_value()) {
+            if (res.is_stopped) {
+                break;
+            }
+            if (prepare) {
+                writer_->prepare_next();
+                prepare = false;
+            }
+            continue;
+        }
+        prepare = prepare || res.item->op == Op::Open;
+        execute(*res.item);
+    }
+    for (auto res = queue_.try_pop(); res.item.has_value(); res = queue_.try_pop()) {
+        execute(*res.item);
+    }
+}
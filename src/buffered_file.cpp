@@ -0,0 +1,268 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "buffered_file.h"
+
+
+BufferedFile::BufferedFile(const WriterOptions& options) : options_(options) {
+    capacity_ = (std::max(options.buffer_size, BLOCK_SIZE) + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    if (posix_memalign(reinterpret_cast<void**>(&buffer_), BLOCK_SIZE, capacity_) != 0) {
+        throw std::runtime_error("allocate write buffer failed");
+    }
+}
+
+
+BufferedFile::~BufferedFile() {
+    close();
+    discard_spare();
+    free(buffer_);
+}
+
+
+/**
+ * 按参数创建文件, 文件系统不支持 O_DIRECT 时退回普通写入
+ */
+int BufferedFile::open_file(const std::string& path, bool& direct) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    direct = false;
+    if (options_.direct_io) {
+        int fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if (fd >= 0) {
+            direct = true;
+            return fd;
+        }
+        if (errno != EINVAL) {
+            std::cerr << "Could not open output file " << path << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
+        std::cerr << "O_DIRECT not supported, fallback to buffered write: " << path << std::endl;
+    }
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        std::cerr << "Could not open output file " << path << ": " << strerror(errno) << std::endl;
+    }
+    return fd;
+}
+
+
+int BufferedFile::open(const std::string& path) {
+    namespace fs = std::filesystem;
+    if (spare_fd_ >= 0 && fs::path(spare_path_).parent_path() == fs::path(path).parent_path() &&
+        rename(spare_path_.c_str(), path.c_str()) == 0) {
+        fd_ = spare_fd_;
+        direct_ = spare_direct_;
+        spare_fd_ = -1;
+        spare_path_.clear();
+    } else {
+        discard_spare();
+        fd_ = open_file(path, direct_);
+        if (fd_ < 0) {
+            return -1;
+        }
+    }
+    used_ = 0;
+    dir_ = fs::path(path).parent_path().string();
+    if (options_.preopen) {
+        if (dir_ != cleaned_dir_) {
+            remove_stale_spares(dir_);
+            cleaned_dir_ = dir_;
+        }
+        spare_due_ = true;
+    }
+    return 0;
+}
+
+
+/**
+ * 在当前文件所在目录创建下一个分段使用的文件, 按预计大小分配空间但不改变文件大小
+ */
+void BufferedFile::prepare_spare() {
+    if (!spare_due_ || spare_fd_ >= 0) {
+        return;
+    }
+    spare_due_ = false;
+    std::string name = ".next_" + std::to_string(getpid()) + "_" +
+                       std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    spare_path_ = (std::filesystem::path(dir_) / name).string();
+    spare_fd_ = open_file(spare_path_, spare_direct_);
+    if (spare_fd_ < 0) {
+        spare_path_.clear();
+        return;
+    }
+    size_t bytes = options_.preallocate_bytes > 0 ? options_.preallocate_bytes : last_size_;
+    if (bytes > 0 && fallocate(spare_fd_, FALLOC_FL_KEEP_SIZE, 0, bytes) != 0 && errno != EOPNOTSUPP) {
+        std::cerr << "fallocate failed: " << strerror(errno) << std::endl;
+    }
+}
+
+
+/**
+ * 删除 dir 中进程已退出的预备文件 (.next_<pid>_<id>.tmp), 崩溃时它们没有机会被清理
+ * 仍在运行的进程 (包括本进程) 的预备文件保留
+ */
+void BufferedFile::remove_stale_spares(const std::string& dir) {
+    namespace fs = std::filesystem;
+    static const std::string PREFIX = ".next_";
+    static const std::string SUFFIX = ".tmp";
+    std::error_code ec;
+    for (fs::directory_iterator it(dir.empty() ? "." : dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() <= PREFIX.size() + SUFFIX.size() || name.compare(0, PREFIX.size(), PREFIX) != 0 ||
+            name.compare(name.size() - SUFFIX.size(), SUFFIX.size(), SUFFIX) != 0) {
+            continue;
+        }
+        char* end_ptr = nullptr;
+        long pid = strtol(name.c_str() + PREFIX.size(), &end_ptr, 10);
+        if (end_ptr == name.c_str() + PREFIX.size() || *end_ptr != '_' || pid <= 0 || pid == getpid()) {
+            continue;
+        }
+        if (kill(static_cast<pid_t>(pid), 0) < 0 && errno == ESRCH) {
+            std::error_code remove_ec;
+            if (fs::remove(it->path(), remove_ec)) {
+                std::cerr << "removed stale spare file: " << it->path().string() << std::endl;
+            }
+        }
+    }
+}
+
+
+void BufferedFile::discard_spare() {
+    if (spare_fd_ < 0) {
+        return;
+    }
+    ::close(spare_fd_);
+    unlink(spare_path_.c_str());
+    spare_fd_ = -1;
+    spare_path_.clear();
+}
+
+
+int BufferedFile::write(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t n = std::min(size, capacity_ - used_);
+        memcpy(buffer_ + used_, data, n);
+        used_ += n;
+        data += n;
+        size -= n;
+        if (used_ == capacity_ && write_out(used_) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * 写出缓冲区前 size 字节, 剩余部分移到缓冲区开头
+ */
+int BufferedFile::write_out(size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(fd_, buffer_ + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "write segment failed: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        done += n;
+    }
+    if (size < used_) {
+        memmove(buffer_, buffer_ + size, used_ - size);
+    }
+    used_ -= size;
+    if (size > 0 && options_.fsync == FsyncPolicy::Batch && fdatasync(fd_) < 0) {
+        std::cerr << "fdatasync failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * 之后的写入不再满足对齐要求, 关闭 O_DIRECT
+ */
+int BufferedFile::disable_direct() {
+    if (!direct_) {
+        return 0;
+    }
+    int flags = fcntl(fd_, F_GETFL);
+    if (flags < 0 || fcntl(fd_, F_SETFL, flags & ~O_DIRECT) < 0) {
+        std::cerr << "disable O_DIRECT failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    direct_ = false;
+    return 0;
+}
+
+
+int BufferedFile::flush() {
+    if (fd_ < 0) {
+        return 0;
+    }
+    size_t size = direct_ ? used_ / BLOCK_SIZE * BLOCK_SIZE : used_;
+    return write_out(size);
+}
+
+
+int64_t BufferedFile::seek(int64_t offset, int whence) {
+    if (fd_ < 0 || disable_direct() < 0 || write_out(used_) < 0) {
+        return -1;
+    }
+    off_t pos = lseek(fd_, offset, whence);
+    if (pos < 0) {
+        std::cerr << "lseek segment failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return pos;
+}
+
+
+int64_t BufferedFile::size() {
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st) < 0) {
+        return -1;
+    }
+    // 缓冲区中的数据从当前文件位置开始
+    return std::max<int64_t>(st.st_size, lseek(fd_, 0, SEEK_CUR) + used_);
+}
+
+
+int BufferedFile::close() {
+    if (fd_ < 0) {
+        return 0;
+    }
+    int ret = 0;
+    if (disable_direct() < 0 || write_out(used_) < 0) {
+        ret = -1;
+        used_ = 0;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) == 0) {
+        last_size_ = st.st_size;
+        if (options_.preopen) {
+            // 释放文件末尾之后未用到的预分配空间
+            ftruncate(fd_, st.st_size);
+        }
+    }
+    if (options_.fsync != FsyncPolicy::None && fsync(fd_) < 0) {
+        std::cerr << "fsync failed: " << strerror(errno) << std::endl;
+        ret = -1;
+    }
+    if (::close(fd_) < 0) {
+        ret = -1;
+    }
+    fd_ = -1;
+    return ret;
+}
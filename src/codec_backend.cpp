@@ -0,0 +1,141 @@
+
+#include <iostream>
+#include <vector>
+
+#include "codec_backend.h"
+#include "encoder.h"
+
+
+static const char* PRESETS[PRESET_LEVELS] = {
+    "ultrafast", "superfast", "veryfast", "faster", "fast",
+    "medium", "slow", "slower", "veryslow"
+};
+
+
+int preset_level(const std::string& preset) {
+    for (int i = 0; i < PRESET_LEVELS; i++) {
+        if (preset == PRESETS[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+const char* preset_name(int level) {
+    return (level >= 0 && level < PRESET_LEVELS) ? PRESETS[level] : nullptr;
+}
+
+
+/**
+ * 拼接 x265-params / svtav1-params 形式的 key=value:key=value 参数
+ */
+static void set_params(AVDictionary** opts, const char* key, const std::vector<std::string>& params) {
+    if (params.empty()) {
+        return;
+    }
+    std::string value;
+    for (const auto& param : params) {
+        if (!value.empty()) {
+            value += ":";
+        }
+        value += param;
+    }
+    av_dict_set(opts, key, value.c_str(), 0);
+}
+
+
+static void apply_rate_control(const EncoderSettings& s, AVDictionary** opts) {
+    if (s.crf >= 0) av_dict_set(opts, "crf", std::to_string(s.crf).c_str(), 0);
+    if (s.qp >= 0) av_dict_set_int(opts, "qp", s.qp, 0);
+}
+
+
+static void apply_x264(const EncoderSettings& s, AVCodecContext* ctx, AVDictionary** opts) {
+    if (!s.preset.empty()) av_dict_set(opts, "preset", s.preset.c_str(), 0);
+    if (!s.tune.empty()) av_dict_set(opts, "tune", s.tune.c_str(), 0);
+    if (!s.profile.empty()) av_dict_set(opts, "profile", s.profile.c_str(), 0);
+    apply_rate_control(s, opts);
+    av_dict_set(opts, "forced-idr", "1", 0);  // 强制的 I 帧编码为 IDR, 用于切分分段
+    if (s.low_latency) {
+        // 条带多线程: 一帧在多个线程中同时编码, 不引入帧级多线程的额外延迟
+        ctx->thread_type = FF_THREAD_SLICE;
+        ctx->max_b_frames = 0;
+        // 无前瞻; 周期性帧内刷新代替 IDR, 每帧码率平稳, 刷新周期为 gop
+        if (s.tune.empty()) av_dict_set(opts, "tune", "zerolatency", 0);
+        av_dict_set(opts, "rc-lookahead", "0", 0);
+        av_dict_set(opts, "intra-refresh", "1", 0);
+    }
+}
+
+
+static void apply_x265(const EncoderSettings& s, AVCodecContext* ctx, AVDictionary** opts) {
+    if (!s.preset.empty()) av_dict_set(opts, "preset", s.preset.c_str(), 0);
+    if (!s.tune.empty()) av_dict_set(opts, "tune", s.tune.c_str(), 0);
+    if (!s.profile.empty()) av_dict_set(opts, "profile", s.profile.c_str(), 0);
+    apply_rate_control(s, opts);
+    av_dict_set(opts, "forced-idr", "1", 0);
+    std::vector<std::string> params;
+    if (s.threads > 0) params.push_back("pools=" + std::to_string(s.threads));
+    if (s.slices > 0) params.push_back("slices=" + std::to_string(s.slices));
+    if (s.low_latency) {
+        ctx->max_b_frames = 0;
+        if (s.tune.empty()) av_dict_set(opts, "tune", "zerolatency", 0);
+        params.push_back("rc-lookahead=0");
+        params.push_back("intra-refresh=1");
+    }
+    set_params(opts, "x265-params", params);
+}
+
+
+/**
+ * SVT-AV1 的 preset 为 0 (最慢) ~ 13 (最快)
+ */
+static void apply_svtav1(const EncoderSettings& s, AVCodecContext* ctx, AVDictionary** opts) {
+    static const int SVT_PRESETS[PRESET_LEVELS] = {12, 11, 10, 9, 8, 7, 5, 4, 2};
+    int level = preset_level(s.preset);
+    if (level >= 0) av_dict_set_int(opts, "preset", SVT_PRESETS[level], 0);
+    apply_rate_control(s, opts);
+    std::vector<std::string> params;
+    if (s.threads > 0) params.push_back("lp=" + std::to_string(s.threads));
+    if (s.low_latency) {
+        params.push_back("pred-struct=1");  // 低延迟预测结构, 不重排帧
+    }
+    set_params(opts, "svtav1-params", params);
+}
+
+
+/**
+ * libaom 的 cpu-used 为 0 (最慢) ~ 8 (最快), 不支持固定 QP
+ */
+static void apply_aom(const EncoderSettings& s, AVCodecContext* ctx, AVDictionary** opts) {
+    static const int AOM_CPU_USED[PRESET_LEVELS] = {8, 8, 7, 6, 5, 4, 3, 2, 1};
+    int level = preset_level(s.preset);
+    if (level >= 0) av_dict_set_int(opts, "cpu-used", AOM_CPU_USED[level], 0);
+    if (s.crf >= 0) av_dict_set(opts, "crf", std::to_string(s.crf).c_str(), 0);
+    if (s.qp >= 0) {
+        std::cerr << "libaom-av1 does not support qp, use crf instead" << std::endl;
+    }
+    if (s.low_latency) {
+        av_dict_set(opts, "usage", "realtime", 0);
+        av_dict_set(opts, "lag-in-frames", "0", 0);
+    }
+}
+
+
+static const CodecBackend BACKENDS[] = {
+    {"libx264",     "h264", ".h264", 23, 35, true,  apply_x264},
+    {"libx265",     "hevc", ".hevc", 28, 38, true,  apply_x265},
+    {"libsvtav1",   "av1",  ".obu",  35, 50, false, apply_svtav1},
+    {"libaom-av1",  "",     ".obu",  32, 50, true,  apply_aom},
+};
+
+
+const CodecBackend* find_codec_backend(const std::string& name) {
+    for (const auto& backend : BACKENDS) {
+        if (name == backend.name || (*backend.alias && name == backend.alias)) {
+            return &backend;
+        }
+    }
+    return nullptr;
+}
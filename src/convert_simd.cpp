@@ -0,0 +1,299 @@
+#include <cstddef>
+#include <cstring>
+
+#include "convert_simd.h"
+
+
+// BT.601 有限范围系数, 8 位定点; 0x1080 = (16 << 8) + 128, 0x8080 = (128 << 8) + 128
+static inline uint8_t rgb_to_y(int r, int g, int b) {
+    return static_cast<uint8_t>((66 * r + 129 * g + 25 * b + 0x1080) >> 8);
+}
+
+static inline uint8_t rgb_to_u(int r, int g, int b) {
+    return static_cast<uint8_t>((112 * b - 74 * g - 38 * r + 0x8080) >> 8);
+}
+
+static inline uint8_t rgb_to_v(int r, int g, int b) {
+    return static_cast<uint8_t>((112 * r - 94 * g - 18 * b + 0x8080) >> 8);
+}
+
+
+/**
+ * 转换一对行中 [x0, width) 的像素, x0 为偶数
+ * 高度为奇数时 row1 与 row0 相同且 dst_y1 为 nullptr
+ */
+static void convert_rows_c(const uint8_t* row0, const uint8_t* row1,
+                           uint8_t* dst_y0, uint8_t* dst_y1, uint8_t* dst_u, uint8_t* dst_v,
+                           int x0, int width) {
+    for (int x = x0; x < width; x += 2) {
+        int x1 = (x + 1 < width) ? x + 1 : x;
+        const uint8_t* p00 = row0 + 3 * x;
+        const uint8_t* p01 = row0 + 3 * x1;
+        const uint8_t* p10 = row1 + 3 * x;
+        const uint8_t* p11 = row1 + 3 * x1;
+        dst_y0[x] = rgb_to_y(p00[2], p00[1], p00[0]);
+        dst_y0[x1] = rgb_to_y(p01[2], p01[1], p01[0]);
+        if (dst_y1) {
+            dst_y1[x] = rgb_to_y(p10[2], p10[1], p10[0]);
+            dst_y1[x1] = rgb_to_y(p11[2], p11[1], p11[0]);
+        }
+        int b = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+        int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+        int r = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+        dst_u[x / 2] = rgb_to_u(r, g, b);
+        dst_v[x / 2] = rgb_to_v(r, g, b);
+    }
+}
+
+
+/**
+ * 向量化实现只处理 step 整数倍的像素, 剩余部分交给标量实现
+ */
+typedef void (*RowsFunc)(const uint8_t* row0, const uint8_t* row1,
+                         uint8_t* dst_y0, uint8_t* dst_y1, uint8_t* dst_u, uint8_t* dst_v, int count);
+
+static void convert_planes(RowsFunc rows_func, int step,
+                           const uint8_t* src, int src_stride,
+                           uint8_t* dst_y, int stride_y,
+                           uint8_t* dst_u, int stride_u,
+                           uint8_t* dst_v, int stride_v,
+                           int width, int height) {
+    int simd_width = rows_func ? width / step * step : 0;
+    for (int y = 0; y < height; y += 2) {
+        const uint8_t* row0 = src + static_cast<ptrdiff_t>(y) * src_stride;
+        uint8_t* y0 = dst_y + static_cast<ptrdiff_t>(y) * stride_y;
+        uint8_t* u = dst_u + static_cast<ptrdiff_t>(y / 2) * stride_u;
+        uint8_t* v = dst_v + static_cast<ptrdiff_t>(y / 2) * stride_v;
+        if (y + 1 < height) {
+            const uint8_t* row1 = row0 + src_stride;
+            uint8_t* y1 = y0 + stride_y;
+            if (simd_width > 0) {
+                rows_func(row0, row1, y0, y1, u, v, simd_width);
+            }
+            convert_rows_c(row0, row1, y0, y1, u, v, simd_width, width);
+        } else {
+            convert_rows_c(row0, row0, y0, nullptr, u, v, 0, width);
+        }
+    }
+}
+
+
+void bgr24_to_i420_c(const uint8_t* src, int src_stride,
+                     uint8_t* dst_y, int stride_y,
+                     uint8_t* dst_u, int stride_u,
+                     uint8_t* dst_v, int stride_v,
+                     int width, int height) {
+    convert_planes(nullptr, 2, src, src_stride, dst_y, stride_y, dst_u, stride_u, dst_v, stride_v, width, height);
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+/**
+ * 将 16 个 BGR24 像素 (48 字节) 拆分为 B、G、R 三个 16 字节向量
+ */
+TARGET_SSSE3 static inline void deinterleave_bgr_ssse3(const uint8_t* p, __m128i& b, __m128i& g, __m128i& r) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+    b = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    g = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    r = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+
+/**
+ * 16 位通道上的亮度/色度计算, 中间结果按模 2^16 回绕, 最终值落在 [0, 65535] 内, 逻辑右移即得正确结果
+ */
+TARGET_SSSE3 static inline __m128i luma_epi16_ssse3(__m128i b, __m128i g, __m128i r) {
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    return _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(0x1080)), 8);
+}
+
+TARGET_SSSE3 static inline void chroma_epi16_ssse3(__m128i b, __m128i g, __m128i r, __m128i& u, __m128i& v) {
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8080));
+    u = _mm_sub_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), _mm_mullo_epi16(g, _mm_set1_epi16(74)));
+    u = _mm_sub_epi16(u, _mm_mullo_epi16(r, _mm_set1_epi16(38)));
+    u = _mm_srli_epi16(_mm_add_epi16(u, bias), 8);
+    v = _mm_sub_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)), _mm_mullo_epi16(g, _mm_set1_epi16(94)));
+    v = _mm_sub_epi16(v, _mm_mullo_epi16(b, _mm_set1_epi16(18)));
+    v = _mm_srli_epi16(_mm_add_epi16(v, bias), 8);
+}
+
+TARGET_SSSE3 static inline __m128i luma_row_ssse3(__m128i b, __m128i g, __m128i r) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = luma_epi16_ssse3(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(r, zero));
+    __m128i hi = luma_epi16_ssse3(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+/**
+ * 两行各 16 个字节求 2x2 均值, 得到 8 个 16 位结果
+ */
+TARGET_SSSE3 static inline __m128i average_2x2_ssse3(__m128i c0, __m128i c1) {
+    const __m128i ones = _mm_set1_epi8(1);
+    __m128i sum = _mm_add_epi16(_mm_maddubs_epi16(c0, ones), _mm_maddubs_epi16(c1, ones));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+
+/**
+ * 每次处理两行各 16 个像素
+ */
+TARGET_SSSE3 static void convert_rows_ssse3(const uint8_t* row0, const uint8_t* row1,
+                                            uint8_t* dst_y0, uint8_t* dst_y1, uint8_t* dst_u, uint8_t* dst_v, int count) {
+    for (int x = 0; x < count; x += 16) {
+        __m128i b0, g0, r0, b1, g1, r1;
+        deinterleave_bgr_ssse3(row0 + 3 * x, b0, g0, r0);
+        deinterleave_bgr_ssse3(row1 + 3 * x, b1, g1, r1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y0 + x), luma_row_ssse3(b0, g0, r0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y1 + x), luma_row_ssse3(b1, g1, r1));
+
+        __m128i u, v;
+        chroma_epi16_ssse3(average_2x2_ssse3(b0, b1), average_2x2_ssse3(g0, g1), average_2x2_ssse3(r0, r1), u, v);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_u + x / 2), _mm_packus_epi16(u, u));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_v + x / 2), _mm_packus_epi16(v, v));
+    }
+}
+
+
+static void bgr24_to_i420_ssse3(const uint8_t* src, int src_stride,
+                                uint8_t* dst_y, int stride_y,
+                                uint8_t* dst_u, int stride_u,
+                                uint8_t* dst_v, int stride_v,
+                                int width, int height) {
+    convert_planes(convert_rows_ssse3, 16, src, src_stride, dst_y, stride_y, dst_u, stride_u, dst_v, stride_v, width, height);
+}
+
+
+TARGET_AVX2 static inline __m256i luma_epi16_avx2(__m256i b, __m256i g, __m256i r) {
+    __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(66)), _mm256_mullo_epi16(g, _mm256_set1_epi16(129)));
+    y = _mm256_add_epi16(y, _mm256_mullo_epi16(b, _mm256_set1_epi16(25)));
+    return _mm256_srli_epi16(_mm256_add_epi16(y, _mm256_set1_epi16(0x1080)), 8);
+}
+
+TARGET_AVX2 static inline void chroma_epi16_avx2(__m256i b, __m256i g, __m256i r, __m256i& u, __m256i& v) {
+    const __m256i bias = _mm256_set1_epi16(static_cast<short>(0x8080));
+    u = _mm256_sub_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(112)), _mm256_mullo_epi16(g, _mm256_set1_epi16(74)));
+    u = _mm256_sub_epi16(u, _mm256_mullo_epi16(r, _mm256_set1_epi16(38)));
+    u = _mm256_srli_epi16(_mm256_add_epi16(u, bias), 8);
+    v = _mm256_sub_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(112)), _mm256_mullo_epi16(g, _mm256_set1_epi16(94)));
+    v = _mm256_sub_epi16(v, _mm256_mullo_epi16(b, _mm256_set1_epi16(18)));
+    v = _mm256_srli_epi16(_mm256_add_epi16(v, bias), 8);
+}
+
+TARGET_AVX2 static inline __m256i combine_avx2(__m128i lo, __m128i hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/**
+ * 32 个像素的亮度; packus 按 128 位通道交错, 需重排 64 位块恢复顺序
+ */
+TARGET_AVX2 static inline __m256i luma_row_avx2(const __m128i b[2], const __m128i g[2], const __m128i r[2]) {
+    __m256i lo = luma_epi16_avx2(_mm256_cvtepu8_epi16(b[0]), _mm256_cvtepu8_epi16(g[0]), _mm256_cvtepu8_epi16(r[0]));
+    __m256i hi = luma_epi16_avx2(_mm256_cvtepu8_epi16(b[1]), _mm256_cvtepu8_epi16(g[1]), _mm256_cvtepu8_epi16(r[1]));
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+}
+
+TARGET_AVX2 static inline __m256i average_2x2_avx2(__m256i c0, __m256i c1) {
+    const __m256i ones = _mm256_set1_epi8(1);
+    __m256i sum = _mm256_add_epi16(_mm256_maddubs_epi16(c0, ones), _mm256_maddubs_epi16(c1, ones));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+}
+
+TARGET_AVX2 static inline __m128i pack_chroma_avx2(__m256i c) {
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(c, c), 0xD8));
+}
+
+
+/**
+ * 每次处理两行各 32 个像素; BGR 拆分沿用 128 位 pshufb, 算术在 256 位上进行
+ */
+TARGET_AVX2 static void convert_rows_avx2(const uint8_t* row0, const uint8_t* row1,
+                                          uint8_t* dst_y0, uint8_t* dst_y1, uint8_t* dst_u, uint8_t* dst_v, int count) {
+    for (int x = 0; x < count; x += 32) {
+        __m128i b0[2], g0[2], r0[2], b1[2], g1[2], r1[2];
+        for (int i = 0; i < 2; i++) {
+            deinterleave_bgr_ssse3(row0 + 3 * (x + 16 * i), b0[i], g0[i], r0[i]);
+            deinterleave_bgr_ssse3(row1 + 3 * (x + 16 * i), b1[i], g1[i], r1[i]);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y0 + x), luma_row_avx2(b0, g0, r0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y1 + x), luma_row_avx2(b1, g1, r1));
+
+        __m256i u, v;
+        chroma_epi16_avx2(average_2x2_avx2(combine_avx2(b0[0], b0[1]), combine_avx2(b1[0], b1[1])),
+                          average_2x2_avx2(combine_avx2(g0[0], g0[1]), combine_avx2(g1[0], g1[1])),
+                          average_2x2_avx2(combine_avx2(r0[0], r0[1]), combine_avx2(r1[0], r1[1])),
+                          u, v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_u + x / 2), pack_chroma_avx2(u));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_v + x / 2), pack_chroma_avx2(v));
+    }
+}
+
+
+static void bgr24_to_i420_avx2(const uint8_t* src, int src_stride,
+                               uint8_t* dst_y, int stride_y,
+                               uint8_t* dst_u, int stride_u,
+                               uint8_t* dst_v, int stride_v,
+                               int width, int height) {
+    convert_planes(convert_rows_avx2, 32, src, src_stride, dst_y, stride_y, dst_u, stride_u, dst_v, stride_v, width, height);
+}
+
+#endif
+
+
+Bgr24ToI420Func select_bgr24_to_i420() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return bgr24_to_i420_avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return bgr24_to_i420_ssse3;
+    }
+#endif
+    return nullptr;
+}
+
+
+const char* bgr24_to_i420_name(Bgr24ToI420Func func) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (func == bgr24_to_i420_avx2) return "avx2";
+    if (func == bgr24_to_i420_ssse3) return "ssse3";
+#endif
+    if (func == bgr24_to_i420_c) return "c";
+    return "swscale";
+}
+
+
+Bgr24ToI420Func find_bgr24_to_i420(const char* name) {
+    if (strcmp(name, "c") == 0) {
+        return bgr24_to_i420_c;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        return bgr24_to_i420_avx2;
+    }
+    if (strcmp(name, "ssse3") == 0 && __builtin_cpu_supports("ssse3")) {
+        return bgr24_to_i420_ssse3;
+    }
+#endif
+    return nullptr;
+}
@@ -1,6 +1,6 @@
 
-
 #include "encoder.h"
+#include "async_segment_writer.h"
 #include "utils.h"
 
 
@@ -16,14 +16,12 @@ static void print_frame_info(const AVFrame* frame) {
 }
 
 
-Encoder::Encoder(int width, int height) : width_(width), height_(height) {
+Encoder::Encoder(int width, int height, AVPixelFormat pix_fmt) : 
+                width_(width), height_(height), pix_fmt_(pix_fmt) {
 }
 
 
 Encoder::~Encoder() {
-    if (frame_in) av_frame_free(&frame_in);
-    if (push_frame) av_frame_free(&push_frame);
-    if (sws_ctx_) sws_freeContext(sws_ctx_);
     if (pkt) av_packet_free(&pkt);
     if (codec_ctx) avcodec_free_context(&codec_ctx);
 }
@@ -37,12 +35,15 @@ int Encoder::init() {
     pkt = av_packet_alloc();
     if (!pkt) {
         std::cerr << "Could not allocate video packet" << std::endl;
-        ret = -1;
+        return -1;
     }
-    if (alloc_input_frame() < 0 || alloc_push_frame() < 0) {
-        std::cerr << "Could not allocate video frame" << std::endl;
-        ret = -1;
+    // 参数确定后才创建写出方式, 异步写出的 I/O 线程只启动一次
+    writer_ = create_writer(settings_);
+    if (!writer_) {
+        std::cerr << "not support container: " << settings_.container << std::endl;
+        return -1;
     }
+    writer_->set_close_listener(segment_listener_);
     if ((ret = codec_init()) < 0) {
         std::cerr << "Could not initialize encoder" << std::endl;
     }
@@ -51,43 +52,104 @@ int Encoder::init() {
 
 
 /**
- * 分配输入图片对应的图像帧
+ * 设置编码参数, 需在 init 之前调用
  */
-int Encoder::alloc_input_frame() {
-    int ret;
-    frame_in = av_frame_alloc();
-    if (!frame_in) {
-        std::cerr << "frame_in av_frame_alloc error" << std::endl;
+int Encoder::set_settings(const EncoderSettings& settings) {
+    if (settings.fps <= 0 || settings.gop <= 0 || settings.bframes < 0 ||
+        settings.threads < 0 || settings.slices < 0 || settings.io_buffer_kb <= 0 ||
+        settings.segment_frames < 0 || settings.segment_seconds < 0 || settings.segment_bytes < 0) {
+        std::cerr << "invalid encoder settings" << std::endl;
         return -1;
     }
-    frame_in->format = AV_PIX_FMT_BGR24;
-    frame_in->width = width_;
-    frame_in->height = height_;
-    ret = av_image_alloc(frame_in->data, frame_in->linesize, width_, height_, AV_PIX_FMT_BGR24, 1);
-    if (ret < 0) {
-        std::cerr << "input_frame alloc failed" << std::endl;
-        av_frame_free(&frame_in);
+    if (settings.crf >= 0 && settings.qp >= 0) {
+        std::cerr << "crf and qp can not be set at the same time" << std::endl;
+        return -1;
     }
-    return ret;
+    const CodecBackend* backend = find_codec_backend(settings.codec);
+    if (!backend) {
+        std::cerr << "not support codec: " << settings.codec << std::endl;
+        return -1;
+    }
+    if (!segment_container_supported(settings.container)) {
+        std::cerr << "not support container: " << settings.container << std::endl;
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    settings_ = settings;
+    backend_ = backend;
+    return 0;
 }
 
 
 /**
- * 分配待推流的图像帧
+ * 运行中修改编码参数, 在下一个分段边界重新打开编码器后生效
  */
-int Encoder::alloc_push_frame() {
-    this->push_frame = av_frame_alloc();
-    if (!(this->push_frame)) {
-        std::cerr << "push_frame av_frame_alloc error" << std::endl;
+int Encoder::reconfigure(const EncoderSettings& settings) {
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    if (settings.fps != settings_.fps || settings.codec != settings_.codec ||
+        settings.container != settings_.container || settings.async_io != settings_.async_io ||
+        settings.io_buffer_kb != settings_.io_buffer_kb || settings.direct_io != settings_.direct_io ||
+        settings.fsync != settings_.fsync || settings.preallocate != settings_.preallocate) {
+        std::cerr << "fps, codec, container and io settings can not be changed at runtime" << std::endl;
+        return -1;
     }
-    this->push_frame->format = AV_PIX_FMT_YUV420P;
-    this->push_frame->width = width_;
-    this->push_frame->height = height_;
+    pending_settings_ = settings;
+    return 0;
+}
+
 
-    int ret = -1;
-    if ((ret = av_frame_get_buffer(this->push_frame, 1)) != 0) {
-        std::cerr << "av_frame_get_buffer error" << std::endl;
-        av_frame_free(&push_frame);
+/**
+ * 按封装与写出参数创建分段写出方式, 不支持的封装返回 nullptr
+ */
+std::unique_ptr<SegmentWriter> Encoder::create_writer(const EncoderSettings& settings) {
+    WriterOptions options;
+    options.buffer_size = static_cast<size_t>(settings.io_buffer_kb) * 1024;
+    options.direct_io = settings.direct_io;
+    options.fsync = settings.fsync;
+    options.preopen = settings.preallocate && settings.async_io;  // 下一个文件在 I/O 线程空闲时准备
+    options.preallocate_bytes = settings.segment_bytes > 0 ? settings.segment_bytes : 0;
+    std::unique_ptr<SegmentWriter> writer = make_segment_writer(settings.container, options);
+    if (writer && settings.async_io) {
+        writer = std::make_unique<AsyncSegmentWriter>(std::move(writer));
+    }
+    return writer;
+}
+
+
+EncoderSettings Encoder::settings() const {
+    std::lock_guard<std::mutex> lock(settings_mtx_);
+    return settings_;
+}
+
+
+/**
+ * 排空当前编码器并写入当前文件, 再重新打开; 有待应用的参数时按新参数打开, 失败则恢复原参数
+ */
+int Encoder::reopen_codec() {
+    EncoderSettings previous;
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(settings_mtx_);
+        previous = settings_;
+        if (pending_settings_) {
+            settings_ = *pending_settings_;
+            pending_settings_.reset();
+            changed = true;
+        }
+    }
+    if (writer_->is_open()) {
+        encode_write();
+    }
+    avcodec_free_context(&codec_ctx);
+    int ret = codec_init();
+    if (ret < 0 && changed) {
+        std::cerr << "reopen codec failed, restore previous settings" << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(settings_mtx_);
+            settings_ = previous;
+        }
+        avcodec_free_context(&codec_ctx);
+        ret = codec_init();
     }
     return ret;
 }
@@ -95,9 +157,9 @@ int Encoder::alloc_push_frame() {
 
 int Encoder::codec_init() {
     int ret = 0;
-    codec = const_cast<AVCodec*>(avcodec_find_encoder(AV_CODEC_ID_H264));
+    codec = avcodec_find_encoder_by_name(backend_->name);
     if (!codec) {
-        fprintf(stderr, "Codec not found\n");
+        fprintf(stderr, "Codec not found: %s\n", backend_->name);
         return -1;
     }
     codec_ctx = avcodec_alloc_context3(codec);
@@ -111,132 +173,54 @@ int Encoder::codec_init() {
 
     this->codec_ctx->width = width_;
     this->codec_ctx->height = height_;
-    this->codec_ctx->time_base = (AVRational){1, fps_};
-    this->codec_ctx->framerate = (AVRational){fps_, 1};
-
-    this->codec_ctx->gop_size = 5;                // 设置为帧数
-    this->codec_ctx->max_b_frames = 0;              // B 帧数目
-    this->codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;  // 编码的图像格式
-
-    // 设置压缩等相关指标
-    if (codec->id == AV_CODEC_ID_H264) {
-        ret = av_opt_set(codec_ctx->priv_data, "preset", "medium", 0);
-        if (ret != 0) {
-            printf("av_opt_set preset failed\n");
-        }
-        ret = av_opt_set(codec_ctx->priv_data, "profile", "main", 0);
-        if (ret != 0) {
-            printf("av_opt_set profile failed\n");
-        }
-    }
-    // 绑定编码器
-    ret = avcodec_open2(codec_ctx, codec, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "avcodec_open2 could not open codec: %d\n", ret);
-        return ret;
-    }
-    return ret;
-}
-
-
-void Encoder::validate_frame_and_mat(const cv::Mat& mat, const AVFrame* frame) {
-    // 检查宽度和高度
-    if (mat.cols != frame->width || mat.rows != frame->height) {
-        throw std::runtime_error(
-            "shape not match: cv::Mat(" + std::to_string(mat.cols) + "x" + std::to_string(mat.rows) + 
-            ") vs AVFrame(" + std::to_string(frame->width) + "x" + std::to_string(frame->height) + ")"
-        );
-    }
-    // 检查通道数
-    int mat_channels = mat.channels();
-    int frame_channels;
-    switch (frame->format) {
-        case AV_PIX_FMT_GRAY8:     frame_channels = 1; break;  // 灰度
-        case AV_PIX_FMT_BGR24:     frame_channels = 3; break;  // OpenCV 默认 BGR
-        case AV_PIX_FMT_RGB24:     frame_channels = 3; break;
-        case AV_PIX_FMT_YUV420P:   frame_channels = 1; break;  // YUV 平面格式
-        default:
-            throw std::runtime_error("not support format of input frame");
-    }
-    if (mat_channels != frame_channels) {
-        throw std::runtime_error(
-            "channels num not match: cv::Mat(" + std::to_string(mat_channels) + 
-            ") vs AVFrame(" + std::to_string(frame_channels) + ")"
-        );
-    }
-}
-
-
-void Encoder::validate_pixel_format(const cv::Mat& mat, AVPixelFormat format) {
-    bool is_compatible = false;
-    switch (mat.type()) {
-        case CV_8UC1:
-            is_compatible = (format == AV_PIX_FMT_GRAY8);
-            break;
-        case CV_8UC3:
-            is_compatible = (format == AV_PIX_FMT_BGR24 || format == AV_PIX_FMT_RGB24);
-            break;
-        case CV_8UC4:
-            is_compatible = (format == AV_PIX_FMT_BGRA || format == AV_PIX_FMT_RGBA);
-            break;
+    this->codec_ctx->time_base = (AVRational){1, settings_.fps};
+    this->codec_ctx->framerate = (AVRational){settings_.fps, 1};
+
+    this->codec_ctx->gop_size = settings_.gop;          // 设置为帧数
+    this->codec_ctx->max_b_frames = settings_.bframes;  // B 帧数目
+    this->codec_ctx->pix_fmt = pix_fmt_;                // 编码的图像格式
+    this->codec_ctx->thread_count = settings_.threads;
+    if (settings_.slices > 0) {
+        this->codec_ctx->slices = settings_.slices;
     }
-    if (!is_compatible) {
-        throw std::runtime_error("pix format not match");
+    if (writer_->global_header()) {
+        // 封装格式的参数集放在文件头中
+        this->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
     }
-}
-
 
-/**
- * 返回此帧的处理结果
- */
-int Encoder::frame_process(const cv::Mat& mat) {
-    int ret = 0;
-    if (!frame_in) {
-        std::cerr << "frame_in not valid " << std::endl;
-        return -1;
-    }
-    validate_frame_and_mat(mat, frame_in);
-    validate_pixel_format(mat, (AVPixelFormat)frame_in->format);
-    
-    ret = av_image_fill_arrays(frame_in->data, frame_in->linesize, 
-                mat.data, AV_PIX_FMT_BGR24, mat.cols, mat.rows, 1);
-    if (ret < 0) {
-        std::cerr << "frame_in fill data failed" << std::endl;
-        return ret;
+    // 设置压缩等相关指标, options 中的同名项优先
+    AVDictionary* opts = nullptr;
+    backend_->apply(settings_, codec_ctx, &opts);
+    for (const auto& kv : settings_.options) {
+        av_dict_set(&opts, kv.first.c_str(), kv.second.c_str(), 0);
     }
-    if ((ret = init_convert()) < 0) {
-        std::cerr << "sws_scale failed: " << ret << "; frame_process exit"<< std::endl;
-        return ret;
+    // 绑定编码器
+    ret = avcodec_open2(codec_ctx, codec, &opts);
+    // 编码器未识别的选项保留在 opts 中
+    AVDictionaryEntry* entry = nullptr;
+    while ((entry = av_dict_get(opts, "", entry, AV_DICT_IGNORE_SUFFIX))) {
+        std::cerr << "encoder option not used: " << entry->key << "=" << entry->value << std::endl;
     }
-    ret = sws_scale(sws_ctx_, frame_in->data, frame_in->linesize, 0, height_, push_frame->data, push_frame->linesize);
+    av_dict_free(&opts);
     if (ret < 0) {
-        std::cerr << "sws_scale failed: " << ret << "; frame_process exit"<< std::endl;
+        fprintf(stderr, "avcodec_open2 could not open codec: %d\n", ret);
         return ret;
     }
-    ret = encode_call();  // 开始编码 push_frame
     return ret;
 }
 
+
 void Encoder::encode_end() {
-    if (output_file_) {
+    if (writer_ && writer_->is_open()) {
         encode_write();
-        fclose(output_file_);
+        close_writer();
     }
-}
-
-int Encoder::init_convert() {
-    int ret = 0;
-    sws_ctx_ = sws_getCachedContext(
-        this->sws_ctx_,
-        width_, height_, AV_PIX_FMT_BGR24,
-        width_, height_, AV_PIX_FMT_YUV420P,
-        SWS_BILINEAR, nullptr, nullptr, nullptr
-    );
-    if (!sws_ctx_) {
-        std::cerr << "sws_ctx_ not valid" << std::endl;
-        return -1;
+    if (writer_ && writer_->wait() < 0) {
+        std::cerr << "segment write failed" << std::endl;
+    }
+    for (auto& sink : sinks_) {
+        sink->close();
     }
-    return ret;
 }
 
 /**
@@ -246,8 +230,14 @@ int Encoder::encode_write(AVFrame* p_frame) {
     int ret;
 
     if (p_frame) {
-        p_frame->pts = pts;
-        pts += 1;
+        // 调用方给出时间戳时沿用 (跳过的帧留下间隔), 否则按帧计数
+        if (p_frame->pts == AV_NOPTS_VALUE || p_frame->pts < pts) {
+            p_frame->pts = pts;
+        }
+        pts = p_frame->pts + 1;
+        if (p_frame->opaque) {
+            enqueue_us_[p_frame->pts] = reinterpret_cast<intptr_t>(p_frame->opaque);
+        }
     }
     ret = avcodec_send_frame(codec_ctx, p_frame);
     if (ret < 0) {
@@ -262,46 +252,244 @@ int Encoder::encode_write(AVFrame* p_frame) {
             fprintf(stderr, "Error encoding audio frame\n");
             return -1;
         }
-        fwrite(pkt->data, 1, pkt->size, output_file_);
+        int64_t packet_pts = pkt->pts;  // 写出时可能换算为封装的时间基
+        int64_t packet_dts = pkt->dts;
+        int size = pkt->size;
+        bool key = pkt->flags & AV_PKT_FLAG_KEY;
+        if (cut_pts_ != AV_NOPTS_VALUE && key && packet_pts >= cut_pts_) {
+            // 强制的关键帧之前的包均已写入上一分段
+            cut_pts_ = AV_NOPTS_VALUE;
+            close_writer();
+            if (start_segment(next_segment_) < 0) {
+                av_packet_unref(pkt);
+                return -1;
+            }
+        }
+        int64_t enqueue_us = take_enqueue_us(packet_pts, packet_dts);
+        if (!sinks_.empty()) {
+            // 写出可能取走包的数据, 先交给其他输出增加引用
+            int64_t capture_us = enqueue_us >= 0 ? enqueue_us : get_time_us();
+            for (auto& sink : sinks_) {
+                sink->write(pkt, capture_us);
+            }
+        }
+        if (writer_->write(pkt) < 0) {
+            av_packet_unref(pkt);
+            return -1;
+        }
+        av_packet_unref(pkt);
+        encoded_frames_++;
+        encoded_bytes_ += size;
+        if (settings_.low_latency) {
+            writer_->flush();
+        }
+        if (enqueue_us >= 0) {
+            record_latency(enqueue_us);
+        }
+        if (catalog_) {
+            record_catalog(packet_pts, enqueue_us, key);
+        }
+        segment_bytes_ += size;
     }
     return 0;
 }
 
 
 /**
- * 更新创建的输出文件
+ * 取出输出包对应帧的入队时刻, 没有记录返回 -1
+ * 有 B 帧时输出包不按 pts 顺序, 只清除匹配的记录; 之后的包 pts 不小于其 dts,
+ * 小于本包 dts 的记录 (帧被编码器丢弃等) 不会再匹配, 一并清除
  */
-int Encoder::update_output_file() {
-    if (output_file_) {
-        fclose(output_file_);
-        output_file_ = nullptr;
+int64_t Encoder::take_enqueue_us(int64_t packet_pts, int64_t packet_dts) {
+    if (packet_dts != AV_NOPTS_VALUE) {
+        enqueue_us_.erase(enqueue_us_.begin(), enqueue_us_.lower_bound(packet_dts));
     }
-    // 可选择其他命名策略
-    std::string filename = std::to_string(get_time_ms()) + ".h264";
-    output_file_ = fopen(filename.c_str(), "wb");
-    if (!output_file_) {
-        fprintf(stderr, "Could not open output file %s\n", filename.c_str());
+    while (enqueue_us_.size() > MAX_PENDING_FRAMES) {
+        // 没有 dts 时按数量兜底
+        enqueue_us_.erase(enqueue_us_.begin());
+    }
+    auto it = enqueue_us_.find(packet_pts);
+    if (it == enqueue_us_.end()) {
         return -1;
     }
-    return 0;
+    int64_t enqueue_us = it->second;
+    enqueue_us_.erase(it);
+    return enqueue_us;
+}
+
+
+/**
+ * 输出包写出后记录对应帧的延迟
+ */
+void Encoder::record_latency(int64_t enqueue_us) {
+    double ms = (get_time_us() - enqueue_us) / 1000.0;
+    std::lock_guard<std::mutex> lock(latency_mtx_);
+    latency_.add(ms);
+}
+
+
+/**
+ * 登记输出包到分段目录, 采集时刻由入队时刻换算为系统时钟
+ * 裸码流的关键帧偏移即此前写出的字节数; 封装格式由其自身的索引 (mfra/Cues) 按 pts 定位
+ */
+void Encoder::record_catalog(int64_t packet_pts, int64_t enqueue_us, bool key) {
+    int64_t capture_us = get_wall_time_us();
+    if (enqueue_us >= 0) {
+        capture_us -= get_time_us() - enqueue_us;
+    }
+    if (!segment_cataloged_) {
+        catalog_->begin_segment(std::filesystem::absolute(segment_path_).string(), packet_pts, capture_us);
+        segment_cataloged_ = true;
+    }
+    int64_t offset = (settings_.container == "raw") ? segment_bytes_ : -1;
+    catalog_->add_packet(packet_pts, capture_us, key, offset);
 }
 
 
-int Encoder::encode_call() {
+LatencyStats Encoder::latency() const {
+    std::lock_guard<std::mutex> lock(latency_mtx_);
+    return latency_;
+}
+
+
+/**
+ * 分段文件名: 创建时刻的毫秒时间戳加进程内递增的序号, 扩展名取决于编码器
+ * 并行分段在入队时命名, 同一毫秒内可能产生多个分段, 序号保证文件名不重复
+ */
+std::string Encoder::segment_name() const {
+    static std::atomic<uint64_t> next_index{0};
+    // 可选择其他命名策略
+    std::string name = std::to_string(get_time_ms()) + "_" + std::to_string(next_index++);
+    if (!segment_suffix_.empty()) {
+        name += "_" + segment_suffix_;
+    }
+    const char* extension = writer_ ? writer_->extension() : nullptr;
+    name += extension ? extension : backend_->extension;
+    return segment_dir_.empty() ? name : (std::filesystem::path(segment_dir_) / name).string();
+}
+
+
+/**
+ * 当前分段是否达到帧数、时长或大小上限
+ */
+bool Encoder::rollover_due() const {
+    if (settings_.segment_frames > 0 && frames_in_segment_ >= settings_.segment_frames) {
+        return true;
+    }
+    if (settings_.segment_seconds > 0 && get_time_us() - segment_start_us_ >= settings_.segment_seconds * 1e6) {
+        return true;
+    }
+    return settings_.segment_bytes > 0 && segment_bytes_ >= settings_.segment_bytes;
+}
+
+
+bool Encoder::at_segment_boundary() const {
+    return !writer_ || !writer_->is_open() || (cut_pts_ == AV_NOPTS_VALUE && rollover_due());
+}
+
+
+/**
+ * 编码一帧已转换的图像, 达到分段上限时切换输出文件, 新分段总是从关键帧开始
+ * 编码器支持强制关键帧时只把本帧设为 I 帧, 输出该帧时切换文件, 编码器不中断;
+ * 否则或有待应用的参数时, 上一分段排空后关闭, 编码器重新打开
+ */
+int Encoder::encode_frame(AVFrame* frame) {
     int ret = 0;
-    if (frame_count % FRAMES_PER_FILE == 0) {
-        if (update_output_file() < 0) {
+    if (at_segment_boundary()) {
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(settings_mtx_);
+            pending = pending_settings_.has_value();
+        }
+        if (writer_->is_open() && backend_->force_keyframe && !pending) {
+            // 与 encode_write 中的时间戳规则一致
+            cut_pts_ = (frame->pts == AV_NOPTS_VALUE || frame->pts < pts) ? pts : frame->pts;
+            next_segment_ = segment_name();
+            frame->pict_type = AV_PICTURE_TYPE_I;
+        } else if (open_segment(segment_name()) < 0) {
+            // 不依赖 avcodec_flush_buffers, 对不支持编码器冲刷的 x265/AV1 同样有效
             return -1;
         }
-        avcodec_flush_buffers(codec_ctx);
+        frames_in_segment_ = 0;
+        segment_start_us_ = get_time_us();
+    }
+    ret = encode_write(frame);
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
+    if (ret < 0) {
+        std::cerr << "encode_write failed, encode_frame exit" << std::endl;
+        return ret;
+    }
+    frame_count++;
+    frames_in_segment_++;
+    return ret;
+}
+
+
+/**
+ * 由调用方管理分段: 打开指定的分段文件, 已有打开的分段时先将其关闭
+ */
+int Encoder::open_segment(const std::string& filename) {
+    if (writer_->is_open() && close_segment() < 0) {
+        return -1;
     }
-    ret = encode_write(push_frame);
+    return start_segment(filename);
+}
+
+
+/**
+ * 关闭当前分段; 写出方式在文件关闭完成后通知监听者
+ */
+int Encoder::close_writer() {
+    int ret = writer_->close();
+    segment_path_.clear();
+    return ret;
+}
+
+
+int Encoder::start_segment(const std::string& filename) {
+    SegmentStream stream = SegmentStream::from_context(codec_ctx);
+    if (writer_->open(filename, stream) < 0) {
+        return -1;
+    }
+    for (auto& sink : sinks_) {
+        sink->set_stream(stream);
+    }
+    segment_path_ = filename;
+    segment_bytes_ = 0;
+    segment_cataloged_ = false;
+    return 0;
+}
+
+
+/**
+ * 编码一帧到当前分段, 不切换文件
+ */
+int Encoder::write_frame(AVFrame* frame) {
+    if (!writer_->is_open()) {
+        std::cerr << "no segment opened, write_frame exit" << std::endl;
+        return -1;
+    }
+    int ret = encode_write(frame);
     if (ret < 0) {
-        std::cerr << "encode_write failed, encode_call exit" << std::endl;
+        std::cerr << "encode_write failed, write_frame exit" << std::endl;
         return ret;
     }
-    if (push_frame) {
-        frame_count++;
+    frame_count++;
+    return ret;
+}
+
+
+/**
+ * 排空编码器后关闭当前分段文件
+ * 编码器随之重新打开, 下一分段从关键帧开始, 与其他分段互不依赖
+ */
+int Encoder::close_segment() {
+    if (!writer_->is_open()) {
+        return 0;
+    }
+    int ret = reopen_codec();
+    if (close_writer() < 0) {
+        ret = -1;
     }
     return ret;
-}
\ No newline at end of file
+}
@@ -0,0 +1,420 @@
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "frame_converter.h"
+
+
+FrameConverter::FrameConverter(int width, int height, AVPixelFormat in_fmt) :
+                width_(width), height_(height), in_fmt_(in_fmt) {
+    switch (in_fmt) {
+        case AV_PIX_FMT_BGR24:
+        case AV_PIX_FMT_RGB24:
+        case AV_PIX_FMT_BGRA:
+        case AV_PIX_FMT_RGBA:
+        case AV_PIX_FMT_GRAY8:
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_NV12:
+            break;
+        default:
+            throw std::invalid_argument("not support format of input frame");
+    }
+    // 输入 Mat 为 height * 3 / 2 行, 色度平面按宽高各一半紧密排列, 奇数宽高时无法按该布局存放
+    if ((in_fmt == AV_PIX_FMT_YUV420P || in_fmt == AV_PIX_FMT_NV12) && (width % 2 != 0 || height % 2 != 0)) {
+        throw std::invalid_argument("width and height of yuv420p/nv12 input must be even");
+    }
+}
+
+
+FrameConverter::~FrameConverter() {
+    if (frame_in) av_frame_free(&frame_in);
+    for (auto ctx : sws_ctxs_) sws_freeContext(ctx);
+    // 已分配出去的缓冲区在引用释放后由 FFmpeg 回收
+    for (int i = 0; i < plane_count_; i++) {
+        av_buffer_pool_uninit(&plane_pools_[i]);
+    }
+}
+
+
+/**
+ * 编码器使用的像素格式: NV12 直接送入编码器, 其余格式转换为 YUV420P
+ */
+AVPixelFormat FrameConverter::output_format() const {
+    return (in_fmt_ == AV_PIX_FMT_NV12) ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P;
+}
+
+
+/**
+ * 输入 cv::Mat 的行数与通道数; YUV 格式的三个平面按行连续存放, 共 height * 3 / 2 行
+ */
+int FrameConverter::input_rows() const {
+    bool is_yuv = (in_fmt_ == AV_PIX_FMT_YUV420P || in_fmt_ == AV_PIX_FMT_NV12);
+    return is_yuv ? height_ * 3 / 2 : height_;
+}
+
+
+int FrameConverter::input_channels() const {
+    switch (in_fmt_) {
+        case AV_PIX_FMT_BGR24:
+        case AV_PIX_FMT_RGB24:     return 3;
+        case AV_PIX_FMT_BGRA:
+        case AV_PIX_FMT_RGBA:      return 4;
+        default:                   return 1;
+    }
+}
+
+
+/**
+ * 灰度输入只写亮度平面, 色度缓冲区分配时即置为中性值, 回收复用后保持不变
+ */
+static AVBufferRef* alloc_neutral_chroma(size_t size) {
+    AVBufferRef* buf = av_buffer_alloc(size);
+    if (buf) {
+        memset(buf->data, 128, size);
+    }
+    return buf;
+}
+
+
+static int align_up(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+/**
+ * 转换器相关初始化工作
+ */
+int FrameConverter::init() {
+    frame_in = av_frame_alloc();
+    if (!frame_in) {
+        std::cerr << "frame_in av_frame_alloc error" << std::endl;
+        return -1;
+    }
+    frame_in->format = in_fmt_;
+    frame_in->width = width_;
+    frame_in->height = height_;
+
+    // 行宽按 32 字节对齐, 末尾预留 64 字节供向量化读取越界
+    const int alignment = 32;
+    const int padding = 64;
+    int chroma_w = (width_ + 1) / 2;
+    int chroma_h = (height_ + 1) / 2;
+    int plane_heights[4] = {height_, chroma_h, chroma_h, 0};
+    plane_linesizes_[0] = align_up(width_, alignment);
+    if (output_format() == AV_PIX_FMT_NV12) {
+        plane_count_ = 2;
+        plane_linesizes_[1] = align_up(chroma_w * 2, alignment);
+    } else {
+        plane_count_ = 3;
+        plane_linesizes_[1] = align_up(chroma_w, alignment);
+        plane_linesizes_[2] = align_up(chroma_w, alignment);
+    }
+    for (int i = 0; i < plane_count_; i++) {
+        bool neutral = (in_fmt_ == AV_PIX_FMT_GRAY8 && i > 0);
+        size_t size = static_cast<size_t>(plane_linesizes_[i]) * plane_heights[i] + padding;
+        plane_pools_[i] = av_buffer_pool_init(size, neutral ? alloc_neutral_chroma : av_buffer_alloc);
+        if (!plane_pools_[i]) {
+            std::cerr << "av_buffer_pool_init error" << std::endl;
+            return -1;
+        }
+    }
+    return init_convert();
+}
+
+
+/**
+ * 从缓冲池取出一个输出帧
+ */
+AVFramePtr FrameConverter::alloc_output_frame() {
+    AVFramePtr frame(av_frame_alloc());
+    if (!frame) {
+        return nullptr;
+    }
+    frame->format = output_format();
+    frame->width = width_;
+    frame->height = height_;
+    for (int i = 0; i < plane_count_; i++) {
+        frame->buf[i] = av_buffer_pool_get(plane_pools_[i]);
+        if (!frame->buf[i]) {
+            return nullptr;
+        }
+        frame->data[i] = frame->buf[i]->data;
+        frame->linesize[i] = plane_linesizes_[i];
+    }
+    return frame;
+}
+
+
+void FrameConverter::validate_frame_and_mat(const cv::Mat& mat, const AVFrame* frame) {
+    // 检查宽度和高度, YUV 平面格式的 Mat 高度为 height * 3 / 2
+    bool is_yuv = (frame->format == AV_PIX_FMT_YUV420P || frame->format == AV_PIX_FMT_NV12);
+    int frame_rows = is_yuv ? frame->height * 3 / 2 : frame->height;
+    if (mat.cols != frame->width || mat.rows != frame_rows) {
+        throw std::runtime_error(
+            "shape not match: cv::Mat(" + std::to_string(mat.cols) + "x" + std::to_string(mat.rows) +
+            ") vs AVFrame(" + std::to_string(frame->width) + "x" + std::to_string(frame_rows) + ")"
+        );
+    }
+    // 检查通道数
+    int mat_channels = mat.channels();
+    int frame_channels;
+    switch (frame->format) {
+        case AV_PIX_FMT_GRAY8:     frame_channels = 1; break;  // 灰度
+        case AV_PIX_FMT_BGR24:     frame_channels = 3; break;  // OpenCV 默认 BGR
+        case AV_PIX_FMT_RGB24:     frame_channels = 3; break;
+        case AV_PIX_FMT_BGRA:      frame_channels = 4; break;
+        case AV_PIX_FMT_RGBA:      frame_channels = 4; break;
+        case AV_PIX_FMT_YUV420P:   frame_channels = 1; break;  // YUV 平面格式
+        case AV_PIX_FMT_NV12:      frame_channels = 1; break;
+        default:
+            throw std::runtime_error("not support format of input frame");
+    }
+    if (mat_channels != frame_channels) {
+        throw std::runtime_error(
+            "channels num not match: cv::Mat(" + std::to_string(mat_channels) +
+            ") vs AVFrame(" + std::to_string(frame_channels) + ")"
+        );
+    }
+}
+
+
+void FrameConverter::validate_pixel_format(const cv::Mat& mat, AVPixelFormat format) {
+    bool is_compatible = false;
+    switch (mat.type()) {
+        case CV_8UC1:
+            is_compatible = (format == AV_PIX_FMT_GRAY8 || format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_NV12);
+            break;
+        case CV_8UC3:
+            is_compatible = (format == AV_PIX_FMT_BGR24 || format == AV_PIX_FMT_RGB24);
+            break;
+        case CV_8UC4:
+            is_compatible = (format == AV_PIX_FMT_BGRA || format == AV_PIX_FMT_RGBA);
+            break;
+    }
+    if (!is_compatible) {
+        throw std::runtime_error("pix format not match");
+    }
+}
+
+
+/**
+ * 返回转换后的图像帧, 失败返回空指针
+ */
+AVFramePtr FrameConverter::convert(const cv::Mat& mat) {
+    int ret = 0;
+    if (!frame_in) {
+        std::cerr << "frame_in not valid " << std::endl;
+        return nullptr;
+    }
+    validate_frame_and_mat(mat, frame_in);
+    validate_pixel_format(mat, (AVPixelFormat)frame_in->format);
+
+    AVFramePtr dst = alloc_output_frame();
+    if (!dst) {
+        std::cerr << "alloc_output_frame failed" << std::endl;
+        return nullptr;
+    }
+    switch (in_fmt_) {
+        case AV_PIX_FMT_GRAY8:
+            ret = copy_gray(mat, dst.get());
+            break;
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_NV12:
+            ret = copy_yuv(mat, dst.get());
+            break;
+        default:
+            // 打包格式直接引用 Mat 的缓冲区, 按 Mat 的行步长访问
+            frame_in->data[0] = mat.data;
+            frame_in->linesize[0] = static_cast<int>(mat.step);
+            ret = convert_frame(dst.get());
+            break;
+    }
+    if (ret < 0) {
+        std::cerr << "frame convert failed: " << ret << std::endl;
+        return nullptr;
+    }
+    return dst;
+}
+
+
+/**
+ * 灰度图直接复制到亮度平面, 色度平面在分配时已置为中性值
+ */
+int FrameConverter::copy_gray(const cv::Mat& mat, AVFrame* dst) {
+    av_image_copy_plane(dst->data[0], dst->linesize[0],
+                        mat.data, static_cast<int>(mat.step), width_, height_);
+    return 0;
+}
+
+
+/**
+ * I420/NV12 的各平面按行连续存放在 Mat 中, 逐平面复制, 无需颜色转换
+ */
+int FrameConverter::copy_yuv(const cv::Mat& mat, AVFrame* dst) {
+    if (!mat.isContinuous()) {
+        std::cerr << "yuv input must be continuous" << std::endl;
+        return -1;
+    }
+    uint8_t* planes[4] = {nullptr};
+    int linesizes[4] = {0};
+    int ret = av_image_fill_arrays(planes, linesizes, mat.data, in_fmt_, width_, height_, 1);
+    if (ret < 0) {
+        std::cerr << "frame_in fill data failed" << std::endl;
+        return ret;
+    }
+    int chroma_h = (height_ + 1) / 2;
+    av_image_copy_plane(dst->data[0], dst->linesize[0], planes[0], linesizes[0], width_, height_);
+    // NV12 的第二个平面为交错的 UV, I420 则为独立的 U、V 平面
+    av_image_copy_plane(dst->data[1], dst->linesize[1], planes[1], linesizes[1], linesizes[1], chroma_h);
+    if (in_fmt_ == AV_PIX_FMT_YUV420P) {
+        av_image_copy_plane(dst->data[2], dst->linesize[2], planes[2], linesizes[2], linesizes[2], chroma_h);
+    }
+    return 0;
+}
+
+
+/**
+ * 设置颜色转换的线程数, 图像按行切分为同样数目的水平条带并行转换
+ * 需在 init 之前调用
+ */
+int FrameConverter::set_convert_threads(int num_threads) {
+    if (num_threads <= 0 || num_threads > height_ / 2) {
+        std::cerr << "invalid convert threads: " << num_threads << std::endl;
+        return -1;
+    }
+    convert_threads_ = num_threads;
+    return 0;
+}
+
+
+/**
+ * 是否使用向量化 BGR24 -> YUV420P 内核, CPU 不支持时仍使用 swscale
+ * 需在 init 之前调用
+ */
+void FrameConverter::set_simd_convert(bool enable) {
+    simd_convert_ = enable;
+}
+
+
+/**
+ * 条带高度取偶数, 保证 YUV420P 色度行与条带边界对齐
+ */
+static int band_height(int height, int bands) {
+    int band = (height + bands - 1) / bands;
+    return (band + 1) & ~1;
+}
+
+
+int FrameConverter::init_convert() {
+    int ret = 0;
+    bool is_packed = (in_fmt_ != AV_PIX_FMT_GRAY8 && in_fmt_ != AV_PIX_FMT_YUV420P && in_fmt_ != AV_PIX_FMT_NV12);
+    if (!is_packed) {
+        return ret;  // 无需颜色转换
+    }
+    if (convert_threads_ > 1 && !convert_pool_) {
+        convert_pool_ = std::make_unique<ThreadPool>(convert_threads_);
+    }
+    if (simd_convert_ && !bgr_kernel_ && in_fmt_ == AV_PIX_FMT_BGR24) {
+        bgr_kernel_ = select_bgr24_to_i420();
+        std::cout << "convert kernel: " << bgr24_to_i420_name(bgr_kernel_) << std::endl;
+    }
+    if (bgr_kernel_) {
+        return ret;
+    }
+    int band = band_height(height_, convert_threads_);
+    sws_ctxs_.resize(convert_threads_, nullptr);
+    for (int i = 0; i < convert_threads_; i++) {
+        int band_h = std::min(band, height_ - i * band);
+        if (band_h <= 0) {
+            break;
+        }
+        sws_ctxs_[i] = sws_getCachedContext(
+            sws_ctxs_[i],
+            width_, band_h, in_fmt_,
+            width_, band_h, AV_PIX_FMT_YUV420P,
+            SWS_BILINEAR, nullptr, nullptr, nullptr
+        );
+        if (!sws_ctxs_[i]) {
+            std::cerr << "sws_ctx_ not valid" << std::endl;
+            return -1;
+        }
+    }
+    return ret;
+}
+
+
+/**
+ * 各条带独立转换, 互不重叠, 无需同步
+ */
+int FrameConverter::convert_frame(AVFrame* dst) {
+    int band = band_height(height_, convert_threads_);
+    std::atomic<int> ret{0};
+    auto convert_band = [&](int i) {
+        int y = i * band;
+        int band_h = std::min(band, height_ - y);
+        if (band_h <= 0) {
+            return;
+        }
+        if (bgr_kernel_) {
+            bgr_kernel_(frame_in->data[0] + y * frame_in->linesize[0], frame_in->linesize[0],
+                        dst->data[0] + y * dst->linesize[0], dst->linesize[0],
+                        dst->data[1] + (y / 2) * dst->linesize[1], dst->linesize[1],
+                        dst->data[2] + (y / 2) * dst->linesize[2], dst->linesize[2],
+                        width_, band_h);
+            return;
+        }
+        if (!sws_ctxs_[i]) {
+            return;
+        }
+        const uint8_t* src[4] = {frame_in->data[0] + y * frame_in->linesize[0], nullptr, nullptr, nullptr};
+        uint8_t* dst_planes[4] = {
+            dst->data[0] + y * dst->linesize[0],
+            dst->data[1] + (y / 2) * dst->linesize[1],
+            dst->data[2] + (y / 2) * dst->linesize[2],
+            nullptr
+        };
+        if (sws_scale(sws_ctxs_[i], src, frame_in->linesize, 0, band_h, dst_planes, dst->linesize) < 0) {
+            ret = -1;
+        }
+    };
+    if (convert_pool_) {
+        convert_pool_->run(convert_threads_, convert_band);
+    } else {
+        convert_band(0);
+    }
+    return ret;
+}
+
+
+int attach_rois(AVFrame* frame, const std::vector<RoiRect>& rois) {
+    std::vector<AVRegionOfInterest> regions;
+    for (const auto& rect : rois) {
+        int left = std::max(rect.x, 0);
+        int top = std::max(rect.y, 0);
+        int right = std::min(rect.x + rect.width, frame->width);
+        int bottom = std::min(rect.y + rect.height, frame->height);
+        if (left >= right || top >= bottom) {
+            continue;
+        }
+        AVRegionOfInterest roi;
+        roi.self_size = sizeof(AVRegionOfInterest);
+        roi.left = left;
+        roi.top = top;
+        roi.right = right;
+        roi.bottom = bottom;
+        roi.qoffset = av_make_q(static_cast<int>(rect.qoffset * 1000), 1000);
+        regions.push_back(roi);
+    }
+    if (regions.empty()) {
+        return 0;
+    }
+    size_t size = regions.size() * sizeof(AVRegionOfInterest);
+    AVFrameSideData* side_data = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST, size);
+    if (!side_data) {
+        std::cerr << "av_frame_new_side_data failed" << std::endl;
+        return -1;
+    }
+    memcpy(side_data->data, regions.data(), size);
+    return 0;
+}
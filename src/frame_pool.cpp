@@ -0,0 +1,134 @@
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "frame_pool.h"
+
+
+FramePool::FramePool(int count, int width, int height, int channels) : 
+                width_(width), height_(height), channels_(channels) {
+    if (count <= 0 || width <= 0 || height <= 0) {
+        throw std::invalid_argument("count, width and height must be greater than 0");
+    }
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw std::invalid_argument("channels must be 1, 3 or 4");
+    }
+    frame_bytes_ = static_cast<size_t>(width) * height * channels;
+    size_t alloc_bytes = (frame_bytes_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    for (int i = 0; i < count; i++) {
+        auto buf = static_cast<uint8_t*>(std::aligned_alloc(ALIGNMENT, alloc_bytes));
+        if (!buf) {
+            for (auto p : buffers_) std::free(p);
+            throw std::bad_alloc();
+        }
+        std::memset(buf, 0, alloc_bytes);  // 预先触发缺页, 避免在取帧路径上发生
+        buffers_.push_back(buf);
+    }
+    // 逆序压栈, 使 acquire 优先取出低序号槽位
+    for (int i = count - 1; i >= 0; i--) {
+        free_slots_.push_back(i);
+    }
+    states_.assign(count, SlotState::Free);
+}
+
+
+FramePool::~FramePool() {
+    for (auto p : buffers_) {
+        std::free(p);
+    }
+}
+
+
+/**
+ * 取出空闲槽位
+ * timeout = -1 表示无限等待
+ */
+int FramePool::acquire(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto wait_predicate = [this] { return stop_ || !free_slots_.empty(); };
+    if (timeout_ms == -1) {
+        cond_var_.wait(lock, wait_predicate);
+    } else if (!cond_var_.wait_for(lock, std::chrono::milliseconds(timeout_ms), wait_predicate)) {
+        return -1;
+    }
+    if (stop_) {
+        return -1;
+    }
+    int slot = free_slots_.back();
+    free_slots_.pop_back();
+    states_[slot] = SlotState::Acquired;
+    return slot;
+}
+
+
+bool FramePool::commit(int slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot < 0 || slot >= count() || states_[slot] != SlotState::Acquired) {
+        return false;
+    }
+    states_[slot] = SlotState::Committed;
+    return true;
+}
+
+
+bool FramePool::release(int slot) {
+    return set_free(slot, SlotState::Acquired);
+}
+
+
+void FramePool::release_committed(int slot) {
+    set_free(slot, SlotState::Committed);
+}
+
+
+/**
+ * 槽位处于 from 状态时归还; 重复归还或非法槽位返回 false
+ */
+bool FramePool::set_free(int slot, SlotState from) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot < 0 || slot >= count() || states_[slot] != from) {
+            return false;
+        }
+        states_[slot] = SlotState::Free;
+        free_slots_.push_back(slot);
+    }
+    cond_var_.notify_one();
+    return true;
+}
+
+
+bool FramePool::is_acquired(int slot) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slot >= 0 && slot < count() && states_[slot] == SlotState::Acquired;
+}
+
+
+void FramePool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_var_.notify_all();
+}
+
+
+cv::Mat FramePool::mat(int slot) const {
+    return cv::Mat(height_, width_, CV_8UC(channels_), data(slot));
+}
+
+
+uint8_t* FramePool::data(int slot) const {
+    if (slot < 0 || slot >= count()) {
+        throw std::out_of_range("invalid frame pool slot: " + std::to_string(slot));
+    }
+    return buffers_[slot];
+}
+
+
+size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_slots_.size();
+}
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "packet_ring.h"
+#include "utils.h"
+
+
+PacketRing::PacketRing(double seconds, size_t max_bytes) :
+                window_us_(static_cast<int64_t>(seconds * 1e6)), max_bytes_(max_bytes) {
+    if (seconds <= 0) {
+        throw std::invalid_argument("clip buffer seconds must be greater than 0");
+    }
+}
+
+
+void PacketRing::set_stream(const SegmentStream& stream) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stream_ = std::make_shared<const SegmentStream>(stream);
+}
+
+
+/**
+ * 增加一个包的引用; 缓冲区为空时丢弃关键帧之前的包
+ */
+void PacketRing::write(const AVPacket* pkt, int64_t capture_us) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (entries_.empty() && !(pkt->flags & AV_PKT_FLAG_KEY)) {
+            return;
+        }
+        AVPacketPtr ref(av_packet_clone(pkt));
+        if (!ref) {
+            std::cerr << "clone packet for clip buffer failed" << std::endl;
+            return;
+        }
+        bytes_ += ref->size;
+        newest_us_ = std::max(newest_us_, capture_us);
+        entries_.push_back({std::move(ref), capture_us, stream_});
+        evict();
+    }
+    cv_.notify_all();
+}
+
+
+/**
+ * 按 GOP 淘汰: 第二个 GOP 已覆盖保留时长, 或超出字节上限时移除第一个 GOP
+ */
+void PacketRing::evict() {
+    while (!entries_.empty()) {
+        size_t next = 1;
+        while (next < entries_.size() && !(entries_[next].pkt->flags & AV_PKT_FLAG_KEY)) {
+            next++;
+        }
+        bool expired = next < entries_.size() && newest_us_ - entries_[next].capture_us >= window_us_;
+        bool over_bytes = max_bytes_ > 0 && bytes_ > max_bytes_;
+        if (!expired && !over_bytes) {
+            return;
+        }
+        for (size_t i = 0; i < next; i++) {
+            bytes_ -= entries_.front().pkt->size;
+            entries_.pop_front();
+        }
+    }
+}
+
+
+void PacketRing::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+}
+
+
+size_t PacketRing::bytes() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return bytes_;
+}
+
+
+static bool same_extradata(const SegmentStream& a, const SegmentStream& b) {
+    return a.par->extradata_size == b.par->extradata_size &&
+           (a.par->extradata_size == 0 || memcmp(a.par->extradata, b.par->extradata, a.par->extradata_size) == 0);
+}
+
+
+/**
+ * 导出采集时刻在 [start_us, end_us] 内的片段 (get_time_us 时钟), 从不晚于 start_us 的最近关键帧开始
+ * end_us 晚于调用时刻时等待后续帧编码完成, 最多等到 end_us 之后 EXPORT_GRACE_US 或缓冲关闭
+ * end_us 不晚于调用时刻时不等待, 导出到已编码的最新包为止
+ * 包的引用在锁内复制, 写文件不阻塞编码线程; 时间戳平移到从 0 开始
+ */
+int PacketRing::export_clip(int64_t start_us, int64_t end_us, const std::string& path, const std::string& container) {
+    std::vector<Entry> clip;
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        int64_t now = get_time_us();
+        if (end_us > now) {
+            cv_.wait_for(lock, std::chrono::microseconds(end_us + EXPORT_GRACE_US - now), [this, end_us] {
+                return closed_ || newest_us_ >= end_us;
+            });
+        }
+        // 有 B 帧时解码顺序上的采集时刻不单调, 关键帧之间有序
+        size_t first = 0;
+        for (size_t i = 0; i < entries_.size(); i++) {
+            if (!(entries_[i].pkt->flags & AV_PKT_FLAG_KEY)) {
+                continue;
+            }
+            if (entries_[i].capture_us > start_us) {
+                break;
+            }
+            first = i;
+        }
+        for (size_t i = first; i < entries_.size() && entries_[i].capture_us <= end_us; i++) {
+            AVPacketPtr ref(av_packet_clone(entries_[i].pkt.get()));
+            if (!ref) {
+                std::cerr << "clone packet for clip failed" << std::endl;
+                return -1;
+            }
+            clip.push_back({std::move(ref), entries_[i].capture_us, entries_[i].stream});
+        }
+    }
+    if (clip.empty() || !clip[0].stream) {
+        std::cerr << "no encoded packets in clip window" << std::endl;
+        return -1;
+    }
+    WriterOptions options;
+    options.preopen = false;
+    std::unique_ptr<SegmentWriter> writer = make_segment_writer(container, options);
+    if (!writer) {
+        std::cerr << "not support container: " << container << std::endl;
+        return -1;
+    }
+    size_t count = clip.size();
+    if (writer->global_header()) {
+        // 编码参数在片段中途改变时全局头可能不同, 只写出与第一个包一致的部分
+        for (size_t i = 1; i < count; i++) {
+            if (clip[i].stream != clip[0].stream && !same_extradata(*clip[i].stream, *clip[0].stream)) {
+                std::cerr << "codec parameters changed, clip truncated: " << path << std::endl;
+                count = i;
+                break;
+            }
+        }
+    }
+    if (writer->open(path, *clip[0].stream) < 0) {
+        return -1;
+    }
+    const AVPacket* head = clip[0].pkt.get();
+    int64_t offset = head->dts != AV_NOPTS_VALUE ? head->dts : head->pts;
+    if (offset == AV_NOPTS_VALUE) {
+        offset = 0;
+    }
+    int ret = 0;
+    for (size_t i = 0; i < count; i++) {
+        AVPacket* pkt = clip[i].pkt.get();
+        if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= offset;
+        if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= offset;
+        if (writer->write(pkt) < 0) {
+            ret = -1;
+            break;
+        }
+    }
+    if (writer->close() < 0) {
+        ret = -1;
+    }
+    return ret;
+}
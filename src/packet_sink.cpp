@@ -0,0 +1,299 @@
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+extern "C" {
+#include <libavcodec/bsf.h>
+}
+
+#include "packet_sink.h"
+#include "utils.h"
+
+
+#if LIBAVCODEC_VERSION_MAJOR >= 59
+typedef size_t SideDataSize;
+#else
+typedef int SideDataSize;
+#endif
+
+
+ThreadedPacketSink::ThreadedPacketSink(int max_pending) : queue_(max_pending) {
+}
+
+
+ThreadedPacketSink::~ThreadedPacketSink() {
+    close();
+}
+
+
+void ThreadedPacketSink::start() {
+    thread_ = std::thread(&ThreadedPacketSink::sink_thread, this);
+}
+
+
+void ThreadedPacketSink::set_stream(const SegmentStream& stream) {
+    stream_ = std::make_shared<const SegmentStream>(stream);
+}
+
+
+/**
+ * 增加包的引用后入队, 不等待; 队列满时丢弃到下一个关键帧, 接收方总能从完整的 GOP 继续解码
+ */
+void ThreadedPacketSink::write(const AVPacket* pkt, int64_t capture_us) {
+    bool key = pkt->flags & AV_PKT_FLAG_KEY;
+    if (skipping_ && !key) {
+        dropped_++;
+        return;
+    }
+    Item item{AVPacketPtr(av_packet_clone(pkt)), capture_us, stream_};
+    if (!item.pkt || !queue_.try_push(item)) {
+        skipping_ = true;
+        dropped_++;
+        return;
+    }
+    skipping_ = false;
+}
+
+
+void ThreadedPacketSink::close() {
+    queue_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+
+void ThreadedPacketSink::sink_thread() {
+    auto process = [this](Item& item) {
+        if (item.stream) {
+            on_packet(std::move(item.pkt), item.capture_us, *item.stream);
+        }
+    };
+    while (true) {
+        PopResult<Item> res = queue_.pop();
+        if (!res.item.has_value()) {
+            if (res.is_stopped) {
+                break;
+            }
+            continue;
+        }
+        process(*res.item);
+    }
+    // pop 在停止后不再返回元素, 处理剩余的包
+    for (auto res = queue_.try_pop(); res.item.has_value(); res = queue_.try_pop()) {
+        process(*res.item);
+    }
+    on_close();
+}
+
+
+/**
+ * 按地址协议选择封装, 返回 nullptr 时由 libavformat 推断
+ */
+static const char* guess_stream_format(const std::string& url) {
+    if (url.rfind("rtmp://", 0) == 0 || url.rfind("rtmps://", 0) == 0) {
+        return "flv";
+    }
+    if (url.rfind("rtsp://", 0) == 0) {
+        return "rtsp";
+    }
+    if (url.rfind("srt://", 0) == 0 || url.rfind("udp://", 0) == 0) {
+        return "mpegts";
+    }
+    return nullptr;
+}
+
+
+/**
+ * 从关键帧的带内参数集 (SPS/PPS 等) 提取全局头, FLV 等封装需要在文件头中写出
+ */
+static int extract_extradata(const AVPacket* pkt, AVCodecParameters* par) {
+    const AVBitStreamFilter* filter = av_bsf_get_by_name("extract_extradata");
+    AVBSFContext* bsf = nullptr;
+    if (!filter || av_bsf_alloc(filter, &bsf) < 0) {
+        return -1;
+    }
+    AVPacket* tmp = av_packet_clone(pkt);
+    int ret = tmp ? avcodec_parameters_copy(bsf->par_in, par) : -1;
+    if (ret >= 0) ret = av_bsf_init(bsf);
+    if (ret >= 0) ret = av_bsf_send_packet(bsf, tmp);
+    if (ret >= 0) ret = av_bsf_receive_packet(bsf, tmp);
+    if (ret >= 0) {
+        SideDataSize size = 0;
+        const uint8_t* data = av_packet_get_side_data(tmp, AV_PKT_DATA_NEW_EXTRADATA, &size);
+        uint8_t* extradata = data ? static_cast<uint8_t*>(av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE)) : nullptr;
+        if (extradata) {
+            memcpy(extradata, data, size);
+            av_freep(&par->extradata);
+            par->extradata = extradata;
+            par->extradata_size = static_cast<int>(size);
+        } else {
+            ret = -1;
+        }
+    }
+    av_packet_free(&tmp);
+    av_bsf_free(&bsf);
+    return ret;
+}
+
+
+StreamSink::StreamSink(const std::string& url, const std::string& format,
+                       const std::map<std::string, std::string>& options) :
+                ThreadedPacketSink(MAX_PENDING), url_(url), format_(format), options_(options) {
+    if (url.empty()) {
+        throw std::invalid_argument("stream url is empty");
+    }
+    avformat_network_init();
+    start();
+}
+
+
+StreamSink::~StreamSink() {
+    close();
+    avformat_network_deinit();
+}
+
+
+/**
+ * 先中断推流线程中阻塞的网络调用, 剩余的包随之写出失败并丢弃
+ */
+void StreamSink::close() {
+    stopping_ = true;
+    ThreadedPacketSink::close();
+}
+
+
+int StreamSink::interrupted(void* opaque) {
+    return static_cast<StreamSink*>(opaque)->stopping_.load() ? 1 : 0;
+}
+
+
+int StreamSink::connect(const SegmentStream& stream, const AVPacket* pkt) {
+    const char* format = format_.empty() ? guess_stream_format(url_) : format_.c_str();
+    int ret = avformat_alloc_output_context2(&fmt_ctx_, nullptr, format, url_.c_str());
+    if (ret < 0 || !fmt_ctx_) {
+        std::cerr << "avformat_alloc_output_context2 failed: " << url_ << ": " << ret << std::endl;
+        return -1;
+    }
+    fmt_ctx_->interrupt_callback.callback = &StreamSink::interrupted;
+    fmt_ctx_->interrupt_callback.opaque = this;
+    AVStream* st = avformat_new_stream(fmt_ctx_, nullptr);
+    if (!st) {
+        std::cerr << "avformat_new_stream failed" << std::endl;
+        return -1;
+    }
+    if ((ret = avcodec_parameters_copy(st->codecpar, stream.par.get())) < 0) {
+        std::cerr << "avcodec_parameters_copy failed: " << ret << std::endl;
+        return ret;
+    }
+    st->codecpar->codec_tag = 0;
+    st->time_base = stream.time_base;
+    st->avg_frame_rate = stream.frame_rate;
+    if (st->codecpar->extradata_size == 0 && extract_extradata(pkt, st->codecpar) < 0) {
+        std::cerr << "extract extradata failed, stream header has no parameter sets: " << url_ << std::endl;
+    }
+
+    AVDictionary* opts = nullptr;
+    for (const auto& kv : options_) {
+        av_dict_set(&opts, kv.first.c_str(), kv.second.c_str(), 0);
+    }
+    if (!av_dict_get(opts, "rw_timeout", nullptr, 0)) {
+        av_dict_set_int(&opts, "rw_timeout", RW_TIMEOUT_US, 0);
+    }
+    if (!(fmt_ctx_->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open2(&fmt_ctx_->pb, url_.c_str(), AVIO_FLAG_WRITE, &fmt_ctx_->interrupt_callback, &opts);
+        if (ret < 0) {
+            std::cerr << "avio_open2 failed: " << url_ << ": " << ret << std::endl;
+            av_dict_free(&opts);
+            return ret;
+        }
+    }
+    ret = avformat_write_header(fmt_ctx_, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "avformat_write_header failed: " << url_ << ": " << ret << std::endl;
+        return ret;
+    }
+    header_written_ = true;
+    const AVCodecParameters* par = stream.par.get();
+    extradata_.assign(par->extradata, par->extradata + par->extradata_size);
+    ts_offset_ = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (ts_offset_ == AV_NOPTS_VALUE) {
+        ts_offset_ = 0;
+    }
+    std::cerr << "stream connected: " << url_ << std::endl;
+    return 0;
+}
+
+
+void StreamSink::disconnect() {
+    if (!fmt_ctx_) {
+        return;
+    }
+    if (header_written_) {
+        av_write_trailer(fmt_ctx_);
+    }
+    if (fmt_ctx_->oformat && !(fmt_ctx_->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&fmt_ctx_->pb);
+    }
+    avformat_free_context(fmt_ctx_);
+    fmt_ctx_ = nullptr;
+    header_written_ = false;
+}
+
+
+void StreamSink::on_packet(AVPacketPtr pkt, int64_t capture_us, const SegmentStream& stream) {
+    const AVCodecParameters* par = stream.par.get();
+    if (fmt_ctx_ && (par->extradata_size != static_cast<int>(extradata_.size()) ||
+                     (par->extradata_size > 0 && memcmp(par->extradata, extradata_.data(), extradata_.size()) != 0))) {
+        std::cerr << "codec parameters changed, reconnect: " << url_ << std::endl;
+        disconnect();
+    }
+    if (!fmt_ctx_) {
+        // 接收方从关键帧开始解码; 关闭过程中不再连接
+        if (!(pkt->flags & AV_PKT_FLAG_KEY) || get_time_us() < retry_us_ || stopping_) {
+            return;
+        }
+        if (connect(stream, pkt.get()) < 0) {
+            disconnect();
+            retry_us_ = get_time_us() + RECONNECT_INTERVAL_US;
+            return;
+        }
+    }
+    AVStream* st = fmt_ctx_->streams[0];
+    if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= ts_offset_;
+    if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= ts_offset_;
+    pkt->stream_index = st->index;
+    av_packet_rescale_ts(pkt.get(), stream.time_base, st->time_base);
+    int ret = av_write_frame(fmt_ctx_, pkt.get());
+    if (ret < 0) {
+        std::cerr << "stream write failed, reconnect later: " << url_ << ": " << ret << std::endl;
+        disconnect();
+        retry_us_ = get_time_us() + RECONNECT_INTERVAL_US;
+    }
+}
+
+
+void StreamSink::on_close() {
+    disconnect();
+}
+
+
+CallbackSink::CallbackSink(PacketCallback callback, int max_pending) :
+                ThreadedPacketSink(max_pending), callback_(std::move(callback)) {
+    if (!callback_) {
+        throw std::invalid_argument("packet callback is empty");
+    }
+    start();
+}
+
+
+CallbackSink::~CallbackSink() {
+    close();
+}
+
+
+void CallbackSink::on_packet(AVPacketPtr pkt, int64_t capture_us, const SegmentStream& stream) {
+    // 入队时刻换算为系统时钟
+    callback_(std::move(pkt), get_wall_time_us() - (get_time_us() - capture_us));
+}
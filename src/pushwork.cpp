@@ -5,9 +5,22 @@
 #include "utils.h"
 
 
-PushWork::PushWork(int queue_size, int width, int height) : 
-                queue_(queue_size),
-                encoder_(width, height) {
+/**
+ * 按 FFmpeg 的格式名解析输入像素格式, 如 bgr24、rgb24、bgra、gray、yuv420p、nv12
+ */
+static AVPixelFormat parse_pix_fmt(const std::string& name) {
+    AVPixelFormat fmt = av_get_pix_fmt(name.c_str());
+    if (fmt == AV_PIX_FMT_NONE) {
+        throw std::invalid_argument("unknown pixel format: " + name);
+    }
+    return fmt;
+}
+
+
+PushWork::PushWork(int queue_size, int width, int height, const std::string& pix_fmt) : 
+                converter_(width, height, parse_pix_fmt(pix_fmt)),
+                encoder_(width, height, converter_.output_format()),
+                queue_(queue_size) {
 }
 
 
@@ -20,16 +33,62 @@ PushWork::~PushWork() {
 
 
 /**
- * 开启线程
+ * 开启线程: 转换与编码分别在独立线程中流水执行
  */
 int PushWork::init() {
     int ret = 0;
-    ret = encoder_.init();
+    ret = converter_.init();
+    if (ret < 0) {
+        return ret;
+    }
+    if (segment_workers_ > 1 && catalog_) {
+        std::cerr << "segment catalog is not supported with parallel segments" << std::endl;
+        return -1;
+    }
+    if (segment_workers_ > 1 && (ring_ || !outputs_.empty())) {
+        std::cerr << "clip buffer and packet outputs are not supported with parallel segments" << std::endl;
+        return -1;
+    }
+    if (segment_workers_ > 1) {
+        try {
+            segment_pool_ = std::make_unique<SegmentEncoderPool>(
+                segment_workers_, converter_.width_, converter_.height_, converter_.output_format(), encoder_.settings());
+        } catch (const std::exception& e) {
+            std::cerr << "create segment pool failed: " << e.what() << std::endl;
+            return -1;
+        }
+        if (retention_) {
+            segment_pool_->set_segment_dir(retention_->directory());
+            segment_pool_->set_segment_listener(segment_listener());
+        }
+        ret = segment_pool_->init();
+    } else {
+        if (retention_) {
+            encoder_.set_segment_dir(retention_->directory());
+        }
+        ret = encoder_.init();
+    }
     if (ret < 0) {
         return ret;
     }
+    for (auto& rendition : renditions_) {
+        if (retention_) {
+            rendition->set_segment_dir(retention_->directory());
+            rendition->set_segment_listener(segment_listener());
+        }
+        if ((ret = rendition->init()) < 0) {
+            return ret;
+        }
+    }
+    if (retention_) {
+        retention_->start();
+    }
+    if (adaptive_speed_ && !segment_pool_) {
+        speed_ctrl_ = std::make_unique<SpeedController>(encoder_.settings());
+    }
     running = true;
     worker_ = std::thread(&PushWork::consumer_thread, this);
+    encode_worker_ = std::thread(&PushWork::encode_thread, this);
     return ret;  
 }
 
@@ -37,6 +96,9 @@ int PushWork::init() {
 void PushWork::stop(int timeout_seconds) {
     running = false;
     queue_.stop();
+    if (pool_) {
+        pool_->stop();
+    }
     std::cerr << "PushWork prepare to stop" << std::endl;
     bool status;
     {
@@ -47,24 +109,483 @@ void PushWork::stop(int timeout_seconds) {
         });
     }
     // 谓词判断为真 条件变量返回
-    if (has_finished_.load() && worker_.joinable()) {
-        worker_.join();
+    if (has_finished_.load()) {
+        if (worker_.joinable()) worker_.join();
+        if (encode_worker_.joinable()) encode_worker_.join();
     } else {
         std::cerr << "PushWork stop status: " << status << std::endl;
     }
 }
 
 
+/**
+ * 设置队列满时的处理策略, 可在运行中切换
+ */
+void PushWork::set_overflow_policy(OverflowPolicy policy) {
+    queue_.set_policy(policy);
+}
+
+
+/**
+ * 按字节数限制队列长度, 0 表示只按帧数限制
+ */
+void PushWork::set_byte_budget(size_t max_bytes) {
+    queue_.set_byte_budget(max_bytes, [](const FrameItem& item) {
+        return item.mat.total() * item.mat.elemSize();
+    });
+}
+
+
+/**
+ * 颜色转换线程数, 需在 init 之前调用
+ */
+int PushWork::set_convert_threads(int num_threads) {
+    return converter_.set_convert_threads(num_threads);
+}
+
+
+void PushWork::set_simd_convert(bool enable) {
+    converter_.set_simd_convert(enable);
+}
+
+
+/**
+ * 编码参数, 需在 init 之前调用
+ */
+int PushWork::set_encoder_settings(const EncoderSettings& settings) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "encoder settings must be set before init" << std::endl;
+        return -1;
+    }
+    return encoder_.set_settings(settings);
+}
+
+
+/**
+ * 按编码耗时与队列深度自动调整 preset/CRF, 需在 init 之前调用
+ */
+int PushWork::set_adaptive_speed(bool enable) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "adaptive speed must be set before init" << std::endl;
+        return -1;
+    }
+    adaptive_speed_ = enable;
+    return 0;
+}
+
+
+/**
+ * 分段并行编码的编码器数目, 1 表示单编码器; 需在 init 之前调用
+ * 各编码器的线程数由 EncoderSettings.threads 决定, 自适应调速在此模式下不生效
+ */
+int PushWork::set_parallel_segments(int workers) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "parallel segments must be set before init" << std::endl;
+        return -1;
+    }
+    if (workers <= 0) {
+        std::cerr << "invalid segment workers: " << workers << std::endl;
+        return -1;
+    }
+    segment_workers_ = workers;
+    return 0;
+}
+
+
+/**
+ * 静止画面检测: 与上一个保留帧的平均每字节差值低于 threshold 时按 mode 处理
+ * max_skip 为连续跳过的最大帧数, 0 表示不限制; 需在 init 之前调用
+ */
+int PushWork::set_static_skip(StaticSkipMode mode, double threshold, int max_skip) {
+    if (worker_.joinable()) {
+        std::cerr << "static skip must be set before init" << std::endl;
+        return -1;
+    }
+    if (mode == StaticSkipMode::Off) {
+        detector_.reset();
+    } else {
+        try {
+            detector_ = std::make_unique<SceneDetector>(threshold, max_skip);
+        } catch (const std::exception& e) {
+            std::cerr << "set_static_skip failed: " << e.what() << std::endl;
+            return -1;
+        }
+    }
+    skip_mode_ = mode;
+    return 0;
+}
+
+
+/**
+ * 增加一路缩小分辨率的输出, 由转换后的帧缩放得到, 使用独立的编码器与分段文件
+ * 未指定编码参数时沿用主输出当前的参数; 需在 init 之前调用
+ */
+int PushWork::add_rendition(int width, int height, std::optional<EncoderSettings> settings) {
+    if (worker_.joinable()) {
+        std::cerr << "rendition must be added before init" << std::endl;
+        return -1;
+    }
+    try {
+        renditions_.push_back(std::make_unique<Rendition>(
+            converter_.width_, converter_.height_, converter_.output_format(),
+            width, height, settings ? *settings : encoder_.settings()));
+    } catch (const std::exception& e) {
+        std::cerr << "add_rendition failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * 取出自上次调用以来按序完成的分段文件, 仅分段并行编码时有效
+ */
+std::vector<std::string> PushWork::completed_segments() {
+    if (!segment_pool_) {
+        return {};
+    }
+    return segment_pool_->take_completed();
+}
+
+
+/**
+ * 主输出的分段目录, 已存在时继续追加; 需在 init 之前调用, 不支持分段并行编码
+ */
+int PushWork::set_catalog(const std::string& path) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "catalog must be set before init" << std::endl;
+        return -1;
+    }
+    try {
+        catalog_ = std::make_shared<SegmentCatalog>(path);
+    } catch (const std::exception& e) {
+        std::cerr << "set_catalog failed: " << e.what() << std::endl;
+        return -1;
+    }
+    encoder_.set_catalog(catalog_);
+    return 0;
+}
+
+
+/**
+ * 分段存储配额: 总字节数超过 max_bytes 或保留超过 max_age_seconds 的最旧分段在后台删除
+ * 任一项为 0 表示不限制; directory 为分段写出的目录, 必须显式指定, 不存在时创建, 启动时扫描一次以接管已有分段
+ * 主输出、缩小分辨率输出与分段并行编码的分段都写入该目录并计入配额; 需在 init 之前调用
+ */
+int PushWork::set_retention(const std::string& directory, int64_t max_bytes, double max_age_seconds) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "retention must be set before init" << std::endl;
+        return -1;
+    }
+    try {
+        retention_ = std::make_shared<RetentionManager>(directory, max_bytes, max_age_seconds);
+    } catch (const std::exception& e) {
+        std::cerr << "set_retention failed: " << e.what() << std::endl;
+        return -1;
+    }
+    encoder_.set_segment_listener(segment_listener());
+    return 0;
+}
+
+
+SegmentListener PushWork::segment_listener() const {
+    std::shared_ptr<RetentionManager> retention = retention_;
+    return [retention](const std::string& path, int64_t bytes) {
+        retention->add(path, bytes);
+    };
+}
+
+
+/**
+ * 查找采集时刻 capture_us (系统时钟, 微秒) 所在的分段文件与之前最近的关键帧
+ */
+std::optional<CatalogEntry> PushWork::lookup(int64_t capture_us) {
+    if (!catalog_) {
+        return std::nullopt;
+    }
+    return catalog_->lookup(capture_us);
+}
+
+
+/**
+ * 在内存中保留主输出最近至少 seconds 秒的编码包 (按 GOP 对齐), 超过 max_bytes 时提前淘汰, 0 表示不限制
+ * 需在 init 之前调用, 不支持分段并行编码
+ */
+int PushWork::set_clip_buffer(double seconds, size_t max_bytes) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "clip buffer must be set before init" << std::endl;
+        return -1;
+    }
+    if (ring_) {
+        std::cerr << "clip buffer already enabled" << std::endl;
+        return -1;
+    }
+    try {
+        ring_ = std::make_shared<PacketRing>(seconds, max_bytes);
+    } catch (const std::exception& e) {
+        std::cerr << "set_clip_buffer failed: " << e.what() << std::endl;
+        return -1;
+    }
+    encoder_.add_sink(ring_);
+    return 0;
+}
+
+
+/**
+ * 导出调用时刻之前 pre_seconds 秒到之后 post_seconds 秒的片段到 path, 复制编码包, 不重新编码
+ * 封装与分段相同; post_seconds 为 0 时不等待, 只导出已编码的包; 大于 0 时阻塞到这段时间的帧编码完成 (最多再等 0.5 s)
+ */
+int PushWork::export_clip(double pre_seconds, double post_seconds, const std::string& path) {
+    if (!ring_) {
+        std::cerr << "clip buffer not enabled" << std::endl;
+        return -1;
+    }
+    if (pre_seconds < 0 || post_seconds < 0) {
+        std::cerr << "invalid clip range" << std::endl;
+        return -1;
+    }
+    int64_t now = get_time_us();
+    return ring_->export_clip(now - static_cast<int64_t>(pre_seconds * 1e6),
+                              now + static_cast<int64_t>(post_seconds * 1e6),
+                              path, encoder_.settings().container);
+}
+
+
+/**
+ * 主输出的编码包同时推流到 url (rtmp/rtsp/srt 等), format 为空时按协议选择封装
+ * options 透传给 libavformat (如 rtsp_transport=tcp), 未指定 rw_timeout 时读写超时 5 s; 需在 init 之前调用, 不支持分段并行编码
+ */
+int PushWork::add_stream_output(const std::string& url, const std::string& format,
+                                const std::map<std::string, std::string>& options) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "stream output must be added before init" << std::endl;
+        return -1;
+    }
+    std::shared_ptr<ThreadedPacketSink> sink;
+    try {
+        sink = std::make_shared<StreamSink>(url, format, options);
+    } catch (const std::exception& e) {
+        std::cerr << "add_stream_output failed: " << e.what() << std::endl;
+        return -1;
+    }
+    outputs_.push_back(sink);
+    encoder_.add_sink(sink);
+    return 0;
+}
+
+
+/**
+ * 主输出的编码包交给回调, 在独立线程中调用, 回调处理不及时丢弃到下一个关键帧
+ * 需在 init 之前调用, 不支持分段并行编码
+ */
+int PushWork::add_packet_callback(PacketCallback callback) {
+    if (encode_worker_.joinable()) {
+        std::cerr << "packet callback must be added before init" << std::endl;
+        return -1;
+    }
+    std::shared_ptr<ThreadedPacketSink> sink;
+    try {
+        sink = std::make_shared<CallbackSink>(std::move(callback));
+    } catch (const std::exception& e) {
+        std::cerr << "add_packet_callback failed: " << e.what() << std::endl;
+        return -1;
+    }
+    outputs_.push_back(sink);
+    encoder_.add_sink(sink);
+    return 0;
+}
+
+
+/**
+ * 开启溢出暂存: 队列满时新帧写入内存映射文件, 消费者取帧后按序读回
+ * 需在写入数据之前调用
+ */
+int PushWork::enable_spill(const std::string& path, size_t capacity_bytes) {
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    if (spill_) {
+        std::cerr << "spill file already enabled" << std::endl;
+        return -1;
+    }
+    try {
+        spill_ = std::make_unique<SpillFile>(path, capacity_bytes);
+    } catch (const std::exception& e) {
+        std::cerr << "enable_spill failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+
+PushStats PushWork::stats() const {
+    PushStats stats;
+    stats.accepted = queue_.accepted_count();
+    stats.dropped = queue_.dropped_count() + spill_dropped_.load();
+    stats.queue_size = queue_.size();
+    stats.queue_bytes = queue_.bytes();
+    stats.spilled = spilled_.load();
+    {
+        std::lock_guard<std::mutex> lock(spill_mtx_);
+        stats.spill_pending = spill_ ? spill_->count() : 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(timing_mtx_);
+        stats.convert_time = convert_time_;
+        stats.encode_time = encode_time_;
+    }
+    if (segment_pool_) {
+        // 并行分段编码时编码线程只分发, 编码耗时取自各工作线程
+        segment_pool_->collect(stats.latency, stats.encode_time, stats.encoded_frames, stats.encoded_bytes);
+    } else {
+        stats.latency = encoder_.latency();
+        stats.encoded_frames = encoder_.encoded_frames();
+        stats.encoded_bytes = encoder_.encoded_bytes();
+    }
+    stats.static_skipped = static_skipped_.load();
+    for (const auto& rendition : renditions_) {
+        stats.renditions.push_back(rendition->stats());
+    }
+    if (retention_) {
+        stats.storage_bytes = retention_->total_bytes();
+        stats.segments_deleted = retention_->deleted();
+    }
+    if (ring_) {
+        stats.clip_buffer_bytes = ring_->bytes();
+    }
+    for (const auto& output : outputs_) {
+        stats.output_dropped += output->dropped();
+    }
+    return stats;
+}
+
+
 /**
  * 暴露给 Python 的接口
+ * holder 非空时 mat 不拥有数据, 由 holder 保证缓冲区在编码完成前有效
+ * rois 为该帧的感兴趣区域, 编码时按区域调整量化
  */
-bool PushWork::put_data(cv::Mat mat) {
-    bool ret = queue_.push(mat);
+bool PushWork::put_data(cv::Mat mat, std::shared_ptr<void> holder, std::vector<RoiRect> rois) {
+    FrameItem item(std::move(mat), std::move(holder));
+    item.rois = std::move(rois);
+    bool ret = enqueue(std::move(item));
     std::cout << "push ret: " << ret << "; queue size: " << queue_.size() << std::endl;
     return ret;
 }
 
 
+/**
+ * 批量入队, 返回每一帧是否入队
+ * holder 为整批帧共享的缓冲区所有者
+ */
+std::vector<bool> PushWork::put_batch(const std::vector<cv::Mat>& mats, std::shared_ptr<void> holder) {
+    std::vector<FrameItem> items;
+    items.reserve(mats.size());
+    for (const auto& mat : mats) {
+        items.emplace_back(mat, holder);
+    }
+    holder.reset();
+    std::vector<bool> ret;
+    if (spill_) {
+        // 溢出暂存需逐帧判断去向
+        for (auto& item : items) {
+            ret.push_back(enqueue(std::move(item)));
+        }
+    } else {
+        ret = queue_.push_batch(std::move(items));  // 未入队的帧随之释放
+    }
+    return ret;
+}
+
+
+/**
+ * 入队一帧; 开启溢出暂存时, 队列已满或暂存区非空的帧写入暂存区
+ */
+bool PushWork::enqueue(FrameItem item) {
+    if (spill_) {
+        std::lock_guard<std::mutex> lock(spill_mtx_);
+        if (spill_->empty() && queue_.try_push(item)) {
+            return true;
+        }
+        if (spill_->write(item)) {
+            spilled_++;
+            return true;
+        }
+        if (!spill_->empty()) {
+            // 暂存区已满, 直接入队会打乱帧序, 丢弃新帧
+            spill_dropped_++;
+            return false;
+        }
+    }
+    return queue_.push(std::move(item));
+}
+
+
+/**
+ * 消费者取帧后从暂存区按序读回, 直到队列再次填满
+ * 只有消费者会腾出队列空间, 持 spill_mtx_ 期间 can_accept 的结果不会失效
+ */
+void PushWork::refill_from_spill() {
+    if (!spill_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    while (!spill_->empty() && queue_.can_accept(spill_->front_bytes())) {
+        auto item = spill_->read();
+        queue_.try_push(*item);
+    }
+}
+
+
+/**
+ * 创建预分配缓冲池, 需在写入数据之前调用
+ * 缓冲区形状与输入格式一致, YUV 格式为 (height * 3 / 2, width) 的单通道图像
+ */
+int PushWork::init_buffer_pool(int count) {
+    if (pool_) {
+        std::cerr << "buffer pool already initialized" << std::endl;
+        return -1;
+    }
+    pool_ = std::make_shared<FramePool>(count, converter_.width_, converter_.input_rows(), converter_.input_channels());
+    return 0;
+}
+
+
+/**
+ * 取出空闲缓冲区槽位, 超时或已停止返回 -1
+ */
+int PushWork::acquire_buffer(int timeout_ms) {
+    if (!pool_) {
+        throw std::runtime_error("buffer pool not initialized");
+    }
+    return pool_->acquire(timeout_ms);
+}
+
+
+/**
+ * 将已写入的槽位入队; 转换阶段读取完该帧后槽位自动归还缓冲池
+ * 入队失败时槽位同样归还; 只接受已取出且未提交的槽位, 重复提交抛出异常
+ */
+bool PushWork::commit_buffer(int slot, std::vector<RoiRect> rois) {
+    if (!pool_ || !pool_->commit(slot)) {
+        throw std::runtime_error("invalid buffer slot: " + std::to_string(slot));
+    }
+    std::shared_ptr<FramePool> pool = pool_;
+    std::shared_ptr<void> holder(pool->data(slot), [pool, slot](void*) {
+        pool->release_committed(slot);
+    });
+    return put_data(pool->mat(slot), std::move(holder), std::move(rois));
+}
+
+
+/**
+ * 放弃已取出但未提交的槽位; 已提交的槽位仍在处理, 不能归还
+ */
+void PushWork::release_buffer(int slot) {
+    if (!pool_ || !pool_->release(slot)) {
+        throw std::runtime_error("invalid buffer slot: " + std::to_string(slot));
+    }
+}
+
+
 /**
  * 线程运行起始时的初始化
  */
@@ -73,15 +594,18 @@ void PushWork::init_params() {
 
 
 /**
- * 线程函数
+ * 转换线程: 取帧并转换为编码格式, 转换完成后即释放输入帧 (归还缓冲池槽位或 numpy 数组)
  */
 void PushWork::consumer_thread() {
     int ret = 0;  // 线程内运行结果反馈
+    int64_t frame_index = 0;  // 输入帧序号, 作为编码时间戳, 跳过的帧同样计数
+    AVFramePtr last_frame;  // 上一个保留帧, 用于重复编码
     init_params();
     while (running && ret >= 0) {
-        PopResult<cv::Mat> res = queue_.pop();
-        auto item = res.item;
+        PopResult<FrameItem> res = queue_.pop();
+        auto& item = res.item;
         bool is_queue_stop = res.is_stopped;
+        refill_from_spill();
         if (!item.has_value()) {
             if (is_queue_stop) {  // 进一步判断是否是队列终止
                 ret = -1;
@@ -91,22 +615,106 @@ void PushWork::consumer_thread() {
             continue;
         }
         try {
-            cv::Mat mat = item.value();
-
-            auto start_time = get_time_ms();
-            encoder_.frame_process(mat);
-            auto end_time = get_time_ms();
-            printf("frame process time cost: %ld ms\n", end_time - start_time);
+            int64_t start_us = get_time_us();
+            int64_t pts = frame_index++;
+            AVFramePtr frame;
+            if (detector_ && detector_->is_static(item->mat)) {
+                static_skipped_++;
+                if (skip_mode_ == StaticSkipMode::Drop || !last_frame) {
+                    continue;
+                }
+                frame.reset(av_frame_clone(last_frame.get()));  // 共享缓冲区, 不复制数据
+            } else {
+                frame = converter_.convert(item->mat);
+                if (frame && !item->rois.empty()) {
+                    attach_rois(frame.get(), item->rois);
+                }
+                if (frame && skip_mode_ == StaticSkipMode::Repeat) {
+                    last_frame.reset(av_frame_clone(frame.get()));
+                }
+            }
+            if (frame) {
+                frame->pts = pts;
+                // 入队时刻随帧传给编码阶段, 用于统计延迟
+                frame->opaque = reinterpret_cast<void*>(static_cast<intptr_t>(item->enqueue_us));
+                for (auto& rendition : renditions_) {
+                    rendition->push(frame.get());
+                }
+            }
+            item.reset();
+            record_time(convert_time_, start_us);
+            if (frame) {
+                yuv_queue_.push(std::move(frame));
+            }
         } catch(const std::exception& e) {
             std::cout << "consumer_thread process error: " << e.what() << std::endl;
         }
     }
-    encoder_.encode_end();
-    set_finish();
+    yuv_queue_.stop();
     std::cout << "consumer_thread end" << std::endl;
 }
 
 
+/**
+ * 编码线程: 编码转换后的图像帧; 转换线程退出后编码剩余帧并冲刷编码器
+ */
+void PushWork::encode_thread() {
+    auto encode = [this](AVFramePtr& frame) {
+        if (segment_pool_) {
+            segment_pool_->push(std::move(frame));
+            return;
+        }
+        if (speed_ctrl_ && encoder_.at_segment_boundary()) {
+            auto next = speed_ctrl_->update(encoder_.settings(), queue_.capacity());
+            if (next) {
+                encoder_.reconfigure(*next);
+            }
+        }
+        int64_t start_us = get_time_us();
+        encoder_.encode_frame(frame.get());
+        double cost_ms = record_time(encode_time_, start_us);
+        if (speed_ctrl_) {
+            speed_ctrl_->record(static_cast<int64_t>(cost_ms), queue_.size());
+        }
+    };
+    while (true) {
+        PopResult<AVFramePtr> res = yuv_queue_.pop();
+        if (!res.item.has_value()) {
+            if (res.is_stopped) {
+                break;
+            }
+            continue;
+        }
+        encode(*res.item);
+    }
+    for (auto res = yuv_queue_.try_pop(); res.item.has_value(); res = yuv_queue_.try_pop()) {
+        encode(*res.item);
+    }
+    if (segment_pool_) {
+        segment_pool_->finish();
+    } else {
+        encoder_.encode_end();
+    }
+    // 转换线程已退出, 不会再有新帧
+    for (auto& rendition : renditions_) {
+        rendition->finish();
+    }
+    set_finish();
+    std::cout << "encode_thread end" << std::endl;
+}
+
+
+/**
+ * 记录从 start_us 到当前的耗时, 返回毫秒数
+ */
+double PushWork::record_time(LatencyStats& stage, int64_t start_us) {
+    double cost_ms = (get_time_us() - start_us) / 1000.0;
+    std::lock_guard<std::mutex> lock(timing_mtx_);
+    stage.add(cost_ms);
+    return cost_ms;
+}
+
+
 void PushWork::set_finish() {
     {
         std::lock_guard<std::mutex> lck(mtx_);
@@ -1,37 +1,348 @@
 
-
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 #include <opencv2/opencv.hpp>
 
 #include "pushwork.h"
 
 namespace py = pybind11;
- 
 
-cv::Mat numpy_to_mat(py::array_t<uint8_t>& array) {
+using NumpyFrame = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>;
+using RoiTuple = std::tuple<int, int, int, int, float>;  // (x, y, width, height, qoffset)
+
+
+/**
+ * 将 numpy 数组包装为 cv::Mat, 不复制数据
+ * 返回的 Mat 不持有缓冲区, 调用方需保证 array 在 Mat 使用期间存活
+ */
+cv::Mat numpy_to_mat(const NumpyFrame& array) {
     py::buffer_info buf = array.request();
     if (buf.ndim != 2 && buf.ndim != 3) {
         throw std::runtime_error("Number of dimensions must be 2 or 3");
     }
     int channels = (buf.ndim == 3) ? buf.shape[2] : 1;
-    cv::Mat mat(buf.shape[0], buf.shape[1], 
-                (channels == 1) ? CV_8UC1 : CV_8UC3, 
-                static_cast<uint8_t*>(buf.ptr));
-    return mat.clone();
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw std::runtime_error("Number of channels must be 1, 3 or 4");
+    }
+    return cv::Mat(buf.shape[0], buf.shape[1], CV_8UC(channels), buf.ptr);
+}
+
+
+/**
+ * 将 (N, H, W, C) 的 numpy 数组包装为 (N * H, W) 的 cv::Mat, 不复制数据
+ */
+cv::Mat numpy_to_block(const NumpyFrame& array, int& count) {
+    py::buffer_info buf = array.request();
+    if (buf.ndim != 4) {
+        throw std::runtime_error("Number of dimensions must be 4 (N, H, W, C)");
+    }
+    count = buf.shape[0];
+    int channels = buf.shape[3];
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw std::runtime_error("Number of channels must be 1, 3 or 4");
+    }
+    return cv::Mat(count * buf.shape[1], buf.shape[2], CV_8UC(channels), buf.ptr);
+}
+
+
+/**
+ * 按帧切分连续内存, 各帧共享 block 的缓冲区
+ */
+std::vector<cv::Mat> split_block(const cv::Mat& block, int count) {
+    std::vector<cv::Mat> mats;
+    if (count <= 0) {
+        return mats;
+    }
+    int rows = block.rows / count;
+    mats.reserve(count);
+    for (int i = 0; i < count; i++) {
+        mats.push_back(block.rowRange(i * rows, (i + 1) * rows));
+    }
+    return mats;
+}
+
+
+/**
+ * 持有 numpy 数组的引用, 帧在消费者线程中释放时重新获取 GIL
+ */
+static std::shared_ptr<void> hold_array(const py::array& array) {
+    return std::shared_ptr<void>(new py::array(array), [](void* p) {
+        py::gil_scoped_acquire gil;
+        delete static_cast<py::array*>(p);
+    });
+}
+
+
+/**
+ * 持有 Python 回调, 在输出线程中释放时重新获取 GIL
+ */
+static std::shared_ptr<py::function> hold_callback(const py::function& callback) {
+    return std::shared_ptr<py::function>(new py::function(callback), [](py::function* p) {
+        py::gil_scoped_acquire gil;
+        delete p;
+    });
+}
+
+
+/**
+ * 编码包数据的只读 numpy 视图, 不复制; 视图持有包的引用, 数组释放时包随之释放
+ */
+static py::array packet_view(AVPacketPtr pkt) {
+    AVPacket* raw = pkt.release();
+    py::capsule owner(raw, [](void* p) {
+        AVPacket* packet = static_cast<AVPacket*>(p);
+        av_packet_free(&packet);
+    });
+    std::vector<ssize_t> shape = {raw->size};
+    std::vector<ssize_t> strides = {1};
+    py::array view = py::array_t<uint8_t>(shape, strides, raw->data, owner);
+    view.attr("setflags")(py::arg("write") = false);
+    return view;
+}
+
+
+/**
+ * 缓冲池槽位对应的可写 numpy 视图, 视图持有 PushWork 对象的引用以保证缓冲池存活
+ */
+static py::array pool_view(py::object owner, const FramePool& pool, int slot) {
+    std::vector<ssize_t> shape = {pool.height(), pool.width()};
+    std::vector<ssize_t> strides = {static_cast<ssize_t>(pool.width()) * pool.channels(), pool.channels()};
+    if (pool.channels() > 1) {
+        shape.push_back(pool.channels());
+        strides.push_back(1);
+    }
+    return py::array_t<uint8_t>(shape, strides, pool.data(slot), owner);
+}
+
+
+/**
+ * Python 侧析构时释放 GIL, 避免等待消费者线程结束时与其释放 numpy 引用互相阻塞
+ */
+struct PushWorkDeleter {
+    void operator()(PushWork* p) const {
+        py::gil_scoped_release release;
+        delete p;
+    }
+};
+
+
+/**
+ * Python 传入的 ROI 元组列表转换为 RoiRect
+ */
+std::vector<RoiRect> to_rois(const std::vector<RoiTuple>& tuples) {
+    std::vector<RoiRect> rois;
+    rois.reserve(tuples.size());
+    for (const auto& t : tuples) {
+        RoiRect rect;
+        std::tie(rect.x, rect.y, rect.width, rect.height, rect.qoffset) = t;
+        if (rect.width <= 0 || rect.height <= 0 || rect.qoffset < -1 || rect.qoffset > 1) {
+            throw std::invalid_argument("invalid roi: size must be positive and qoffset in [-1, 1]");
+        }
+        rois.push_back(rect);
+    }
+    return rois;
 }
 
 
 PYBIND11_MODULE(compressor, m) {
-    py::class_<PushWork>(m, "PushWork")
-        .def(py::init<int, int, int>(),
+    py::enum_<OverflowPolicy>(m, "OverflowPolicy")
+        .value("BLOCK", OverflowPolicy::Block)
+        .value("DROP_NEWEST", OverflowPolicy::DropNewest)
+        .value("DROP_OLDEST", OverflowPolicy::DropOldest)
+        .value("LATEST_ONLY", OverflowPolicy::LatestOnly);
+
+    py::enum_<StaticSkipMode>(m, "StaticSkipMode")
+        .value("OFF", StaticSkipMode::Off)
+        .value("DROP", StaticSkipMode::Drop)
+        .value("REPEAT", StaticSkipMode::Repeat);
+
+    py::enum_<FsyncPolicy>(m, "FsyncPolicy")
+        .value("NONE", FsyncPolicy::None)
+        .value("SEGMENT", FsyncPolicy::Segment)
+        .value("BATCH", FsyncPolicy::Batch);
+
+    py::class_<EncoderSettings>(m, "EncoderSettings")
+        .def(py::init<>())
+        .def_readwrite("codec", &EncoderSettings::codec)
+        .def_readwrite("container", &EncoderSettings::container)
+        .def_readwrite("async_io", &EncoderSettings::async_io)
+        .def_readwrite("io_buffer_kb", &EncoderSettings::io_buffer_kb)
+        .def_readwrite("direct_io", &EncoderSettings::direct_io)
+        .def_readwrite("fsync", &EncoderSettings::fsync)
+        .def_readwrite("preallocate", &EncoderSettings::preallocate)
+        .def_readwrite("segment_frames", &EncoderSettings::segment_frames)
+        .def_readwrite("segment_seconds", &EncoderSettings::segment_seconds)
+        .def_readwrite("segment_bytes", &EncoderSettings::segment_bytes)
+        .def_readwrite("preset", &EncoderSettings::preset)
+        .def_readwrite("tune", &EncoderSettings::tune)
+        .def_readwrite("profile", &EncoderSettings::profile)
+        .def_readwrite("crf", &EncoderSettings::crf)
+        .def_readwrite("qp", &EncoderSettings::qp)
+        .def_readwrite("gop", &EncoderSettings::gop)
+        .def_readwrite("bframes", &EncoderSettings::bframes)
+        .def_readwrite("threads", &EncoderSettings::threads)
+        .def_readwrite("slices", &EncoderSettings::slices)
+        .def_readwrite("fps", &EncoderSettings::fps)
+        .def_readwrite("low_latency", &EncoderSettings::low_latency)
+        .def_readwrite("options", &EncoderSettings::options);
+
+    py::class_<CatalogEntry>(m, "CatalogEntry")
+        .def_readonly("file", &CatalogEntry::file)
+        .def_readonly("offset", &CatalogEntry::offset)
+        .def_readonly("pts", &CatalogEntry::pts)
+        .def_readonly("capture_us", &CatalogEntry::capture_us)
+        .def_readonly("segment_end_us", &CatalogEntry::segment_end_us);
+
+    // 其他进程以只读方式打开同一目录查询
+    py::class_<SegmentCatalog>(m, "SegmentCatalog")
+        .def(py::init<const std::string&, bool>(), py::arg("path"), py::arg("read_only") = true)
+        .def("lookup", &SegmentCatalog::lookup, py::arg("capture_us"))
+        .def("segment_count", &SegmentCatalog::segment_count)
+        .def("key_count", &SegmentCatalog::key_count);
+
+    py::class_<PushWork, std::unique_ptr<PushWork, PushWorkDeleter>>(m, "PushWork")
+        .def(py::init<int, int, int, const std::string&>(),
              py::arg("queue_size"),
              py::arg("width"),
-             py::arg("height"))
+             py::arg("height"),
+             py::arg("pix_fmt") = "bgr24")
         .def("init", &PushWork::init)
-        .def("stop", &PushWork::stop)
-        .def("put_data", [](PushWork& self, py::array_t<uint8_t> arr) {
+        .def("stop", &PushWork::stop, py::call_guard<py::gil_scoped_release>())
+        .def("put_data", [](PushWork& self, NumpyFrame arr, bool copy, const std::vector<RoiTuple>& rois) {
             cv::Mat mat = numpy_to_mat(arr);
-            return self.put_data(mat);
+            std::vector<RoiRect> rects = to_rois(rois);
+            if (copy) {
+                // arr 在本函数返回前保持存活, 释放 GIL 后再复制
+                py::gil_scoped_release release;
+                return self.put_data(mat.clone(), nullptr, std::move(rects));
+            }
+            // 零拷贝: 队列中的帧持有 arr 的引用, 调用方不应再修改该数组
+            auto holder = hold_array(arr);
+            py::gil_scoped_release release;
+            return self.put_data(mat, std::move(holder), std::move(rects));
+        }, py::arg("arr"), py::arg("copy") = true, py::arg("rois") = std::vector<RoiTuple>())
+        .def("put_batch", [](PushWork& self, NumpyFrame arr, bool copy) {
+            int count = 0;
+            cv::Mat block = numpy_to_block(arr, count);
+            std::vector<bool> accepted;
+            if (copy) {
+                // 整批只复制一次
+                py::gil_scoped_release release;
+                accepted = self.put_batch(split_block(block.clone(), count));
+            } else {
+                auto holder = hold_array(arr);
+                py::gil_scoped_release release;
+                accepted = self.put_batch(split_block(block, count), std::move(holder));
+            }
+            py::list ret;
+            for (bool ok : accepted) {
+                ret.append(ok);
+            }
+            return ret;
+        }, py::arg("arr"), py::arg("copy") = true)
+        .def("init_buffer_pool", &PushWork::init_buffer_pool, py::arg("count"))
+        .def("acquire_buffer", [](py::object self_obj, int timeout_ms) -> py::object {
+            PushWork& self = self_obj.cast<PushWork&>();
+            int slot;
+            {
+                py::gil_scoped_release release;
+                slot = self.acquire_buffer(timeout_ms);
+            }
+            if (slot < 0) {
+                return py::none();
+            }
+            return py::make_tuple(slot, pool_view(self_obj, *self.buffer_pool(), slot));
+        }, py::arg("timeout_ms") = -1)
+        .def("commit_buffer", [](PushWork& self, int slot, const std::vector<RoiTuple>& rois) {
+            std::vector<RoiRect> rects = to_rois(rois);
+            py::gil_scoped_release release;
+            return self.commit_buffer(slot, std::move(rects));
+        }, py::arg("slot"), py::arg("rois") = std::vector<RoiTuple>())
+        .def("release_buffer", &PushWork::release_buffer, py::arg("slot"))
+        .def("set_overflow_policy", &PushWork::set_overflow_policy, py::arg("policy"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("set_byte_budget", &PushWork::set_byte_budget, py::arg("max_bytes"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("set_convert_threads", &PushWork::set_convert_threads, py::arg("num_threads"))
+        .def("set_simd_convert", &PushWork::set_simd_convert, py::arg("enable"))
+        .def("set_encoder_settings", &PushWork::set_encoder_settings, py::arg("settings"))
+        .def("encoder_settings", &PushWork::encoder_settings)
+        .def("set_adaptive_speed", &PushWork::set_adaptive_speed, py::arg("enable"))
+        .def("set_parallel_segments", &PushWork::set_parallel_segments, py::arg("workers"))
+        .def("completed_segments", &PushWork::completed_segments)
+        .def("set_catalog", &PushWork::set_catalog, py::arg("path"))
+        .def("set_retention", &PushWork::set_retention,
+             py::arg("directory"), py::arg("max_bytes"), py::arg("max_age_seconds") = 0)
+        .def("lookup", &PushWork::lookup, py::arg("capture_us"))
+        .def("add_stream_output", &PushWork::add_stream_output,
+             py::arg("url"),
+             py::arg("format") = "",
+             py::arg("options") = std::map<std::string, std::string>())
+        .def("add_packet_tap", [](PushWork& self, const py::function& callback) {
+            // 在输出线程中调用 callback(data, pts, key, capture_us), data 为编码包的只读视图, 不复制
+            std::shared_ptr<py::function> fn = hold_callback(callback);
+            return self.add_packet_callback([fn](AVPacketPtr pkt, int64_t capture_us) {
+                py::gil_scoped_acquire gil;
+                int64_t pts = pkt->pts;
+                bool key = pkt->flags & AV_PKT_FLAG_KEY;
+                try {
+                    (*fn)(packet_view(std::move(pkt)), pts, key, capture_us);
+                } catch (py::error_already_set& e) {
+                    std::cerr << "packet tap callback failed: " << e.what() << std::endl;
+                }
+            });
+        }, py::arg("callback"))
+        .def("set_clip_buffer", &PushWork::set_clip_buffer, py::arg("seconds"), py::arg("max_bytes") = 0)
+        .def("export_clip", &PushWork::export_clip,
+             py::arg("pre_s"), py::arg("post_s"), py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("add_rendition", &PushWork::add_rendition,
+             py::arg("width"),
+             py::arg("height"),
+             py::arg("settings") = std::nullopt)
+        .def("set_static_skip", &PushWork::set_static_skip,
+             py::arg("mode"),
+             py::arg("threshold") = 1.0,
+             py::arg("max_skip") = 0)
+        .def("enable_spill", &PushWork::enable_spill,
+             py::arg("path"),
+             py::arg("capacity_bytes"))
+        .def("stats", [](const PushWork& self) {
+            PushStats stats = self.stats();
+            py::dict ret;
+            ret["accepted"] = stats.accepted;
+            ret["dropped"] = stats.dropped;
+            ret["queue_size"] = stats.queue_size;
+            ret["queue_bytes"] = stats.queue_bytes;
+            ret["spilled"] = stats.spilled;
+            ret["spill_pending"] = stats.spill_pending;
+            ret["latency_frames"] = stats.latency.count;
+            ret["latency_last_ms"] = stats.latency.last_ms;
+            ret["latency_avg_ms"] = stats.latency.avg_ms;
+            ret["latency_max_ms"] = stats.latency.max_ms;
+            ret["convert_avg_ms"] = stats.convert_time.avg_ms;
+            ret["convert_max_ms"] = stats.convert_time.max_ms;
+            ret["encode_avg_ms"] = stats.encode_time.avg_ms;
+            ret["encode_max_ms"] = stats.encode_time.max_ms;
+            ret["encoded_frames"] = stats.encoded_frames;
+            ret["encoded_bytes"] = stats.encoded_bytes;
+            ret["static_skipped"] = stats.static_skipped;
+            py::list renditions;
+            for (const auto& r : stats.renditions) {
+                py::dict item;
+                item["width"] = r.width;
+                item["height"] = r.height;
+                item["encoded_frames"] = r.encoded_frames;
+                item["encoded_bytes"] = r.encoded_bytes;
+                item["dropped"] = r.dropped;
+                renditions.append(item);
+            }
+            ret["renditions"] = renditions;
+            ret["storage_bytes"] = stats.storage_bytes;
+            ret["segments_deleted"] = stats.segments_deleted;
+            ret["clip_buffer_bytes"] = stats.clip_buffer_bytes;
+            ret["output_dropped"] = stats.output_dropped;
+            return ret;
         });
-}
\ No newline at end of file
+}
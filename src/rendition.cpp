@@ -0,0 +1,118 @@
+
+#include "rendition.h"
+
+
+Rendition::Rendition(int src_width, int src_height, AVPixelFormat pix_fmt,
+                     int width, int height, const EncoderSettings& settings) :
+                src_width_(src_width), src_height_(src_height), pix_fmt_(pix_fmt),
+                width_(width), height_(height),
+                encoder_(width, height, pix_fmt) {
+    if (width <= 0 || height <= 0 || width % 2 || height % 2 || width > src_width || height > src_height) {
+        throw std::invalid_argument("rendition size must be even and not larger than the input");
+    }
+    if (encoder_.set_settings(settings) < 0) {
+        throw std::invalid_argument("invalid encoder settings");
+    }
+    encoder_.set_segment_suffix(std::to_string(width) + "x" + std::to_string(height));
+}
+
+
+Rendition::~Rendition() {
+    finish();
+    if (sws_ctx_) sws_freeContext(sws_ctx_);
+}
+
+
+int Rendition::init() {
+    // 面积平均缩小, 避免大比例缩小时的混叠
+    sws_ctx_ = sws_getContext(src_width_, src_height_, pix_fmt_,
+                              width_, height_, pix_fmt_,
+                              SWS_AREA, nullptr, nullptr, nullptr);
+    if (!sws_ctx_) {
+        std::cerr << "rendition sws_getContext failed" << std::endl;
+        return -1;
+    }
+    if (encoder_.init() < 0) {
+        return -1;
+    }
+    thread_ = std::thread(&Rendition::encode_thread, this);
+    return 0;
+}
+
+
+/**
+ * 只增加全分辨率帧的引用, 不复制数据; 队列满时丢弃
+ */
+void Rendition::push(const AVFrame* frame) {
+    AVFramePtr ref(av_frame_clone(frame));
+    if (!ref || !queue_.push(std::move(ref), 0)) {
+        dropped_++;
+    }
+}
+
+
+void Rendition::finish() {
+    queue_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+
+RenditionStats Rendition::stats() const {
+    RenditionStats stats;
+    stats.width = width_;
+    stats.height = height_;
+    stats.encoded_frames = encoder_.encoded_frames();
+    stats.encoded_bytes = encoder_.encoded_bytes();
+    stats.dropped = dropped_.load();
+    return stats;
+}
+
+
+AVFramePtr Rendition::scale(const AVFrame* src) {
+    AVFramePtr dst(av_frame_alloc());
+    if (!dst) {
+        return nullptr;
+    }
+    dst->format = pix_fmt_;
+    dst->width = width_;
+    dst->height = height_;
+    if (av_frame_get_buffer(dst.get(), 0) < 0) {
+        std::cerr << "rendition av_frame_get_buffer failed" << std::endl;
+        return nullptr;
+    }
+    if (sws_scale(sws_ctx_, src->data, src->linesize, 0, src_height_, dst->data, dst->linesize) < 0) {
+        std::cerr << "rendition sws_scale failed" << std::endl;
+        return nullptr;
+    }
+    dst->pts = src->pts;
+    dst->opaque = src->opaque;
+    return dst;
+}
+
+
+void Rendition::encode_thread() {
+    auto encode = [this](AVFramePtr& frame) {
+        AVFramePtr scaled = scale(frame.get());
+        frame.reset();  // 尽早归还全分辨率缓冲区
+        if (scaled) {
+            encoder_.encode_frame(scaled.get());
+        }
+    };
+    while (true) {
+        PopResult<AVFramePtr> res = queue_.pop();
+        if (!res.item.has_value()) {
+            if (res.is_stopped) {
+                break;
+            }
+            continue;
+        }
+        encode(*res.item);
+    }
+    for (auto res = queue_.try_pop(); res.item.has_value(); res = queue_.try_pop()) {
+        encode(*res.item);
+    }
+    encoder_.encode_end();
+    std::cout << "rendition " << width_ << "x" << height_ << " end" << std::endl;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <regex>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "retention_manager.h"
+#include "utils.h"
+
+
+// linux/ioprio.h 未随 glibc 提供
+static const int IOPRIO_WHO_PROCESS = 1;
+static const int IOPRIO_CLASS_IDLE = 3;
+static const int IOPRIO_CLASS_SHIFT = 13;
+
+
+/**
+ * 当前线程降为最低 CPU 优先级与 idle I/O 调度类, 只在磁盘空闲时删除文件
+ */
+static void lower_thread_priority() {
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, 19) != 0) {
+        std::cerr << "setpriority failed: " << strerror(errno) << std::endl;
+    }
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        std::cerr << "ioprio_set failed: " << strerror(errno) << std::endl;
+    }
+}
+
+
+RetentionManager::RetentionManager(const std::string& directory, int64_t max_bytes, double max_age_seconds) :
+                max_bytes_(max_bytes), max_age_us_(static_cast<int64_t>(max_age_seconds * 1e6)) {
+    namespace fs = std::filesystem;
+    if (directory.empty()) {
+        throw std::invalid_argument("segment directory must be specified");
+    }
+    if (max_bytes < 0 || max_age_seconds < 0 || (max_bytes == 0 && max_age_seconds == 0)) {
+        throw std::invalid_argument("max_bytes or max_age_seconds must be greater than 0");
+    }
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec || !fs::is_directory(directory)) {
+        throw std::runtime_error("create segment directory failed: " + directory);
+    }
+    fs::path dir = fs::absolute(directory).lexically_normal();
+    if (!dir.has_filename()) {
+        dir = dir.parent_path();  // 去掉末尾的分隔符, 与文件的 parent_path 比较
+    }
+    directory_ = dir.string();
+}
+
+
+/**
+ * path 是否直接位于分段目录中
+ */
+bool RetentionManager::in_directory(const std::string& path) const {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path parent = fs::absolute(path, ec).lexically_normal().parent_path();
+    return !ec && parent == fs::path(directory_);
+}
+
+
+RetentionManager::~RetentionManager() {
+    stop();
+}
+
+
+void RetentionManager::start() {
+    scan();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&RetentionManager::retention_thread, this);
+}
+
+
+void RetentionManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+
+/**
+ * 登记之前运行留下的分段, 按修改时间排在新分段之前
+ * 只接管 Encoder::segment_name 生成的文件名: <13 位毫秒时间戳>_<序号>[_<宽>x<高>].<扩展名>,
+ * 目录中其他文件 (包括同样以数字命名的视频) 不计入配额, 也不会被删除
+ */
+void RetentionManager::scan() {
+    namespace fs = std::filesystem;
+    static const std::regex SEGMENT_NAME(R"(\d{13}_\d+(_\d+x\d+)?\.(h264|hevc|obu|mp4|mkv))");
+    std::vector<Segment> found;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        if (!entry.is_regular_file(ec) || !std::regex_match(entry.path().filename().string(), SEGMENT_NAME)) {
+            continue;
+        }
+        auto mtime = fs::last_write_time(entry.path(), ec);
+        if (ec) {
+            continue;
+        }
+        // file_time_type 的纪元与系统时钟不同, 按当前时刻换算
+        auto age = fs::file_time_type::clock::now() - mtime;
+        int64_t closed_us = get_wall_time_us() - std::chrono::duration_cast<std::chrono::microseconds>(age).count();
+        found.push_back({fs::absolute(entry.path()).string(), static_cast<int64_t>(entry.file_size(ec)), closed_us});
+    }
+    if (ec) {
+        std::cerr << "scan segment directory failed: " << directory_ << ": " << ec.message() << std::endl;
+    }
+    std::sort(found.begin(), found.end(), [](const Segment& a, const Segment& b) {
+        // 修改时间相同时按文件名 (创建时刻) 排序
+        return a.closed_us != b.closed_us ? a.closed_us < b.closed_us : a.path < b.path;
+    });
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto it = found.rbegin(); it != found.rend(); ++it) {
+        total_bytes_ += it->bytes;
+        segments_.push_front(std::move(*it));
+    }
+}
+
+
+/**
+ * 只登记分段目录中的文件, 调用方指定路径的分段 (open_segment) 不计入配额
+ */
+void RetentionManager::add(const std::string& path, int64_t bytes) {
+    if (!in_directory(path)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        segments_.push_back({path, bytes, get_wall_time_us()});
+        total_bytes_ += bytes;
+    }
+    cv_.notify_one();
+}
+
+
+int64_t RetentionManager::total_bytes() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return total_bytes_;
+}
+
+
+bool RetentionManager::over_quota(int64_t now_us) const {
+    if (segments_.empty()) {
+        return false;
+    }
+    if (max_bytes_ > 0 && total_bytes_ > max_bytes_) {
+        return true;
+    }
+    return max_age_us_ > 0 && now_us - segments_.front().closed_us > max_age_us_;
+}
+
+
+void RetentionManager::retention_thread() {
+    lower_thread_priority();
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (running_) {
+        if (!over_quota(get_wall_time_us())) {
+            cv_.wait_for(lock, std::chrono::milliseconds(CHECK_INTERVAL_MS));
+            continue;
+        }
+        Segment oldest = std::move(segments_.front());
+        segments_.pop_front();
+        total_bytes_ -= oldest.bytes;
+        lock.unlock();
+        if (unlink(oldest.path.c_str()) == 0) {
+            deleted_++;
+        } else if (errno != ENOENT) {
+            std::cerr << "delete segment failed: " << oldest.path << ": " << strerror(errno) << std::endl;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(DELETE_INTERVAL_MS));
+        lock.lock();
+    }
+}
@@ -0,0 +1,140 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "scene_detector.h"
+
+
+/**
+ * 两行字节的绝对差之和, 标量实现, 也是向量化实现的参照
+ */
+uint64_t sad_row_c(const uint8_t* a, const uint8_t* b, size_t n) {
+    uint64_t sad = 0;
+    for (size_t i = 0; i < n; i++) {
+        sad += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+    }
+    return sad;
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+TARGET_SSE2
+static uint64_t sum_epi64(__m128i v) {
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+    return lanes[0] + lanes[1];
+}
+
+
+TARGET_SSE2
+static uint64_t sad_row_sse2(const uint8_t* a, const uint8_t* b, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    return sum_epi64(acc) + sad_row_c(a + i, b + i, n - i);
+}
+
+
+TARGET_AVX2
+static uint64_t sad_row_avx2(const uint8_t* a, const uint8_t* b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+    }
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return sum_epi64(sum) + sad_row_sse2(a + i, b + i, n - i);
+}
+
+#endif
+
+
+/**
+ * 按运行时 CPU 特性选择实现 (AVX2 > SSE2 > 标量)
+ */
+static SadRowFunc select_sad_row() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return sad_row_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return sad_row_sse2;
+    }
+#endif
+    return sad_row_c;
+}
+
+
+SadRowFunc find_sad_row(const char* name) {
+    if (strcmp(name, "c") == 0) {
+        return sad_row_c;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        return sad_row_avx2;
+    }
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        return sad_row_sse2;
+    }
+#endif
+    return nullptr;
+}
+
+
+SceneDetector::SceneDetector(double threshold, int max_skip) :
+                threshold_(threshold), max_skip_(max_skip) {
+    if (threshold < 0 || max_skip < 0) {
+        throw std::invalid_argument("threshold and max_skip must not be negative");
+    }
+}
+
+
+bool SceneDetector::is_static(const cv::Mat& mat) {
+    static const SadRowFunc sad_row = select_sad_row();
+    size_t row_bytes = mat.cols * mat.elemSize();
+    if (reference_.empty() || mat.rows != rows_ || row_bytes != row_bytes_) {
+        store(mat);
+        return false;
+    }
+    uint64_t sad = 0;
+    size_t bytes = 0;
+    const uint8_t* ref = reference_.data();
+    for (int i = 0; i < rows_; i += ROW_STEP) {
+        sad += sad_row(mat.ptr(i), ref, row_bytes_);
+        ref += row_bytes_;
+        bytes += row_bytes_;
+    }
+    last_diff_ = static_cast<double>(sad) / bytes;
+    if (last_diff_ < threshold_ && (max_skip_ == 0 || skipped_ < max_skip_)) {
+        skipped_++;
+        return true;
+    }
+    store(mat);
+    return false;
+}
+
+
+void SceneDetector::store(const cv::Mat& mat) {
+    rows_ = mat.rows;
+    row_bytes_ = mat.cols * mat.elemSize();
+    reference_.resize(((rows_ + ROW_STEP - 1) / ROW_STEP) * row_bytes_);
+    uint8_t* ref = reference_.data();
+    for (int i = 0; i < rows_; i += ROW_STEP) {
+        memcpy(ref, mat.ptr(i), row_bytes_);
+        ref += row_bytes_;
+    }
+    skipped_ = 0;
+}
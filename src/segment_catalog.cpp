@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "segment_catalog.h"
+
+
+static const char CATALOG_MAGIC[8] = {'S', 'E', 'G', 'C', 'A', 'T', '0', '1'};
+static const size_t INITIAL_RECORDS = 1024;
+
+// 文件头: magic[8] | record_size (uint32) | 保留 | count (uint64, 偏移 16)
+static const size_t RECORD_SIZE_OFFSET = 8;
+static const size_t COUNT_OFFSET = 16;
+
+
+MappedTable::MappedTable(const std::string& path, uint32_t record_size, bool read_only) :
+                path_(path), record_size_(record_size), read_only_(read_only) {
+    fd_ = open(path.c_str(), read_only ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("could not open catalog file " + path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close(fd_);
+        throw std::runtime_error("could not stat catalog file " + path + ": " + strerror(errno));
+    }
+    size_t bytes = st.st_size;
+    bool created = false;
+    if (bytes == 0 && !read_only) {
+        bytes = HEADER_SIZE + INITIAL_RECORDS * record_size;
+        if (ftruncate(fd_, bytes) != 0) {
+            close(fd_);
+            throw std::runtime_error("could not resize catalog file " + path + ": " + strerror(errno));
+        }
+        created = true;
+    }
+    if (bytes < HEADER_SIZE) {
+        close(fd_);
+        throw std::runtime_error("invalid catalog file " + path);
+    }
+    map(bytes);
+    if (created) {
+        memcpy(map_, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+        memcpy(map_ + RECORD_SIZE_OFFSET, &record_size, sizeof(record_size));
+    } else {
+        uint32_t stored_size;
+        memcpy(&stored_size, map_ + RECORD_SIZE_OFFSET, sizeof(stored_size));
+        if (memcmp(map_, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 || stored_size != record_size) {
+            munmap(map_, map_bytes_);
+            close(fd_);
+            throw std::runtime_error("invalid catalog file " + path);
+        }
+    }
+}
+
+
+MappedTable::~MappedTable() {
+    if (map_) munmap(map_, map_bytes_);
+    if (fd_ >= 0) close(fd_);
+}
+
+
+void MappedTable::map(size_t bytes) {
+    void* addr = mmap(nullptr, bytes, read_only_ ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("could not map catalog file " + path_ + ": " + strerror(errno));
+    }
+    if (map_) {
+        munmap(map_, map_bytes_);
+    }
+    map_ = static_cast<uint8_t*>(addr);
+    map_bytes_ = bytes;
+}
+
+
+uint64_t MappedTable::count() const {
+    return __atomic_load_n(reinterpret_cast<uint64_t*>(map_ + COUNT_OFFSET), __ATOMIC_ACQUIRE);
+}
+
+
+const uint8_t* MappedTable::record(uint64_t index) {
+    size_t end = HEADER_SIZE + (index + 1) * record_size_;
+    if (end > map_bytes_) {
+        // 写入方扩大了文件
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < end) {
+            throw std::out_of_range("catalog record out of range: " + path_);
+        }
+        map(st.st_size);
+    }
+    return map_ + HEADER_SIZE + index * record_size_;
+}
+
+
+uint8_t* MappedTable::mutable_record(uint64_t index) {
+    return const_cast<uint8_t*>(record(index));
+}
+
+
+/**
+ * 空间不足时文件扩大一倍; 提交前崩溃留下的空间在重新打开后被覆盖
+ */
+uint8_t* MappedTable::append() {
+    uint64_t n = count();
+    size_t end = HEADER_SIZE + (n + 1) * record_size_;
+    if (end > map_bytes_) {
+        size_t bytes = std::max(end, map_bytes_ * 2);
+        if (ftruncate(fd_, bytes) != 0) {
+            throw std::runtime_error("could not resize catalog file " + path_ + ": " + strerror(errno));
+        }
+        map(bytes);
+    }
+    uint8_t* rec = map_ + HEADER_SIZE + n * record_size_;
+    memset(rec, 0, record_size_);
+    return rec;
+}
+
+
+void MappedTable::commit() {
+    __atomic_store_n(reinterpret_cast<uint64_t*>(map_ + COUNT_OFFSET), count() + 1, __ATOMIC_RELEASE);
+}
+
+
+SegmentCatalog::SegmentCatalog(const std::string& path, bool read_only) :
+                read_only_(read_only),
+                segments_(path + ".segments", sizeof(SegmentRecord), read_only),
+                keys_(path + ".keys", sizeof(KeyRecord), read_only) {
+}
+
+
+/**
+ * 新分段的第一个输出包写出时调用
+ */
+int SegmentCatalog::begin_segment(const std::string& file, int64_t pts, int64_t capture_us) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (read_only_) {
+        return -1;
+    }
+    if (file.size() >= sizeof(SegmentRecord::file)) {
+        std::cerr << "segment path too long for catalog: " << file << std::endl;
+        return -1;
+    }
+    try {
+        SegmentRecord* rec = reinterpret_cast<SegmentRecord*>(segments_.append());
+        memcpy(rec->file, file.c_str(), file.size() + 1);
+        rec->first_pts = rec->last_pts = pts;
+        rec->first_us = rec->last_us = capture_us;
+        rec->first_key = keys_.count();
+        rec->key_count = 0;
+        segments_.commit();
+    } catch (const std::exception& e) {
+        std::cerr << "catalog begin_segment failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+
+int SegmentCatalog::add_packet(int64_t pts, int64_t capture_us, bool key, int64_t offset) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint64_t count = segments_.count();
+    if (read_only_ || count == 0) {
+        return -1;
+    }
+    try {
+        SegmentRecord* seg = reinterpret_cast<SegmentRecord*>(segments_.mutable_record(count - 1));
+        // 有 B 帧时输出包的 pts 不单调
+        seg->last_pts = std::max(seg->last_pts, pts);
+        seg->last_us = std::max(seg->last_us, capture_us);
+        if (!key) {
+            return 0;
+        }
+        uint64_t n = keys_.count();
+        if (n > 0) {
+            const KeyRecord* prev = reinterpret_cast<const KeyRecord*>(keys_.record(n - 1));
+            capture_us = std::max(capture_us, prev->capture_us);
+        }
+        KeyRecord* rec = reinterpret_cast<KeyRecord*>(keys_.append());
+        rec->capture_us = capture_us;
+        rec->pts = pts;
+        rec->offset = offset;
+        rec->segment = count - 1;
+        keys_.commit();
+        seg->key_count++;
+    } catch (const std::exception& e) {
+        std::cerr << "catalog add_packet failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * 查找采集时刻不晚于 capture_us 的最近关键帧, 从该位置解码即可得到 capture_us 时刻的帧
+ */
+std::optional<CatalogEntry> SegmentCatalog::lookup(int64_t capture_us) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint64_t lo = 0;
+    uint64_t hi = keys_.count();
+    // 第一个采集时刻晚于 capture_us 的关键帧
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        const KeyRecord* rec = reinterpret_cast<const KeyRecord*>(keys_.record(mid));
+        if (rec->capture_us <= capture_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return std::nullopt;
+    }
+    const KeyRecord* key = reinterpret_cast<const KeyRecord*>(keys_.record(lo - 1));
+    if (key->segment >= segments_.count()) {
+        return std::nullopt;
+    }
+    const SegmentRecord* seg = reinterpret_cast<const SegmentRecord*>(segments_.record(key->segment));
+    CatalogEntry entry;
+    entry.file = std::string(seg->file, strnlen(seg->file, sizeof(seg->file)));
+    entry.offset = key->offset;
+    entry.pts = key->pts;
+    entry.capture_us = key->capture_us;
+    entry.segment_end_us = seg->last_us;
+    return entry;
+}
+
+
+uint64_t SegmentCatalog::segment_count() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return segments_.count();
+}
+
+
+uint64_t SegmentCatalog::key_count() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return keys_.count();
+}
@@ -0,0 +1,195 @@
+
+#include "segment_encoder_pool.h"
+#include "utils.h"
+
+
+SegmentEncoderPool::SegmentEncoderPool(int workers, int width, int height,
+                                       AVPixelFormat pix_fmt, const EncoderSettings& settings) {
+    if (workers <= 0) {
+        throw std::invalid_argument("workers must be greater than 0");
+    }
+    segment_frames_ = settings.segment_frames;
+    if (segment_frames_ <= 0) {
+        segment_frames_ = static_cast<int>(settings.segment_seconds * settings.fps + 0.5);
+    }
+    if (segment_frames_ <= 0) {
+        throw std::invalid_argument("parallel segments require segment_frames or segment_seconds");
+    }
+    if (settings.segment_bytes > 0) {
+        std::cerr << "segment_bytes is ignored by parallel segments" << std::endl;
+    }
+    for (int i = 0; i < workers; i++) {
+        auto worker = std::make_unique<Worker>(segment_frames_);
+        worker->encoder = std::make_unique<Encoder>(width, height, pix_fmt);
+        if (worker->encoder->set_settings(settings) < 0) {
+            throw std::invalid_argument("invalid encoder settings");
+        }
+        workers_.push_back(std::move(worker));
+    }
+}
+
+
+SegmentEncoderPool::~SegmentEncoderPool() {
+    finish();
+}
+
+
+int SegmentEncoderPool::init() {
+    for (auto& worker : workers_) {
+        if (worker->encoder->init() < 0) {
+            return -1;
+        }
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&SegmentEncoderPool::worker_thread, this, worker.get());
+    }
+    return 0;
+}
+
+
+void SegmentEncoderPool::set_segment_dir(const std::string& dir) {
+    for (auto& worker : workers_) {
+        worker->encoder->set_segment_dir(dir);
+    }
+}
+
+
+void SegmentEncoderPool::set_segment_listener(const SegmentListener& listener) {
+    for (auto& worker : workers_) {
+        worker->encoder->set_segment_listener(listener);
+    }
+}
+
+
+/**
+ * 按分段轮询分发; 目标线程的队列已满时阻塞
+ */
+bool SegmentEncoderPool::push(AVFramePtr frame) {
+    SegmentFrame item;
+    item.frame = std::move(frame);
+    item.segment = segment_;
+    if (frame_in_segment_ == 0) {
+        item.filename = workers_[0]->encoder->segment_name();
+    }
+    item.last = (++frame_in_segment_ == segment_frames_);
+    Worker* worker = workers_[segment_ % workers_.size()].get();
+    if (item.last) {
+        frame_in_segment_ = 0;
+        segment_++;
+    }
+    return worker->queue.push(std::move(item));
+}
+
+
+void SegmentEncoderPool::finish() {
+    for (auto& worker : workers_) {
+        worker->queue.stop();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+
+std::vector<std::string> SegmentEncoderPool::take_completed() {
+    std::lock_guard<std::mutex> lock(done_mtx_);
+    std::vector<std::string> ret;
+    ret.swap(completed_);
+    return ret;
+}
+
+
+void SegmentEncoderPool::collect(LatencyStats& latency, LatencyStats& encode_time, uint64_t& frames, uint64_t& bytes) const {
+    for (const auto& worker : workers_) {
+        latency.merge(worker->encoder->latency());
+        {
+            std::lock_guard<std::mutex> lock(worker->timing_mtx);
+            encode_time.merge(worker->encode_time);
+        }
+        frames += worker->encoder->encoded_frames();
+        bytes += worker->encoder->encoded_bytes();
+    }
+}
+
+
+/**
+ * 记录分段完成, 前序分段均已完成时依次上报; 失败的分段以空文件名占位, 不上报
+ */
+void SegmentEncoderPool::complete(uint64_t segment, const std::string& filename) {
+    std::lock_guard<std::mutex> lock(done_mtx_);
+    done_[segment] = filename;
+    for (auto it = done_.find(next_report_); it != done_.end(); it = done_.find(next_report_)) {
+        if (!it->second.empty()) {
+            std::cout << "segment " << it->first << " completed: " << it->second << std::endl;
+            completed_.push_back(std::move(it->second));
+        }
+        done_.erase(it);
+        next_report_++;
+    }
+}
+
+
+/**
+ * 工作线程: 编码分给本线程的分段; 队列停止后编码剩余帧并关闭未完成的分段
+ */
+void SegmentEncoderPool::worker_thread(Worker* worker) {
+    Encoder& encoder = *worker->encoder;
+    bool is_open = false;
+    uint64_t open_segment = 0;
+    std::string open_name;
+
+    auto handle = [&](SegmentFrame& item) {
+        if (!item.filename.empty()) {
+            is_open = (encoder.open_segment(item.filename) == 0);
+            open_segment = item.segment;
+            open_name = is_open ? item.filename : "";
+            if (!is_open) {
+                complete(open_segment, "");
+            }
+        }
+        if (!is_open || item.segment != open_segment) {
+            return;  // 分段打开失败, 丢弃该段剩余帧
+        }
+        int64_t start_us = get_time_us();
+        int ret = encoder.write_frame(item.frame.get());
+        double cost_ms = (get_time_us() - start_us) / 1000.0;
+        {
+            std::lock_guard<std::mutex> lock(worker->timing_mtx);
+            worker->encode_time.add(cost_ms);
+        }
+        item.frame.reset();
+        if (ret < 0) {
+            open_name.clear();
+        }
+        if (item.last) {
+            if (encoder.close_segment() < 0) {
+                open_name.clear();
+            }
+            is_open = false;
+            complete(open_segment, open_name);
+        }
+    };
+
+    while (true) {
+        PopResult<SegmentFrame> res = worker->queue.pop();
+        if (!res.item.has_value()) {
+            if (res.is_stopped) {
+                break;
+            }
+            continue;
+        }
+        handle(*res.item);
+    }
+    for (auto res = worker->queue.try_pop(); res.item.has_value(); res = worker->queue.try_pop()) {
+        handle(*res.item);
+    }
+    if (is_open) {
+        if (encoder.close_segment() < 0) {
+            open_name.clear();
+        }
+        complete(open_segment, open_name);
+    }
+    std::cout << "segment worker end" << std::endl;
+}
@@ -0,0 +1,234 @@
+
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "segment_writer.h"
+
+
+static const int AVIO_BUFFER_SIZE = 64 * 1024;
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+typedef const uint8_t* AvioWriteBuffer;
+#else
+typedef uint8_t* AvioWriteBuffer;
+#endif
+
+
+SegmentStream SegmentStream::from_context(const AVCodecContext* codec_ctx) {
+    SegmentStream stream;
+    stream.par.reset(avcodec_parameters_alloc(), [](AVCodecParameters* par) {
+        avcodec_parameters_free(&par);
+    });
+    if (!stream.par || avcodec_parameters_from_context(stream.par.get(), codec_ctx) < 0) {
+        throw std::runtime_error("copy codec parameters failed");
+    }
+    stream.time_base = codec_ctx->time_base;
+    stream.frame_rate = codec_ctx->framerate;
+    return stream;
+}
+
+
+/**
+ * 以关闭后的实际文件大小通知监听者; 文件已不存在时不通知
+ */
+void SegmentWriter::notify_closed(const std::string& path) {
+    if (!close_listener_) {
+        return;
+    }
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        std::cerr << "stat closed segment failed: " << path << ": " << ec.message() << std::endl;
+        return;
+    }
+    close_listener_(std::filesystem::absolute(path).string(), static_cast<int64_t>(size));
+}
+
+
+RawSegmentWriter::RawSegmentWriter(const WriterOptions& options) : file_(options) {
+}
+
+
+int RawSegmentWriter::open(const std::string& path, const SegmentStream& stream) {
+    if (file_.open(path) < 0) {
+        return -1;
+    }
+    path_ = path;
+    return 0;
+}
+
+
+int RawSegmentWriter::write(AVPacket* pkt) {
+    return file_.write(pkt->data, pkt->size);
+}
+
+
+void RawSegmentWriter::flush() {
+    file_.flush();
+}
+
+
+int RawSegmentWriter::close() {
+    if (!file_.is_open()) {
+        return 0;
+    }
+    int ret = file_.close();
+    notify_closed(path_);
+    path_.clear();
+    return ret;
+}
+
+
+static int avio_write_packet(void* opaque, AvioWriteBuffer buf, int size) {
+    BufferedFile* file = static_cast<BufferedFile*>(opaque);
+    return file->write(buf, size) < 0 ? AVERROR(EIO) : size;
+}
+
+
+static int64_t avio_seek(void* opaque, int64_t offset, int whence) {
+    BufferedFile* file = static_cast<BufferedFile*>(opaque);
+    if (whence & AVSEEK_SIZE) {
+        return file->size();
+    }
+    int64_t pos = file->seek(offset, whence & ~AVSEEK_FORCE);
+    return pos < 0 ? AVERROR(EIO) : pos;
+}
+
+
+ContainerSegmentWriter::ContainerSegmentWriter(const std::string& container, const WriterOptions& options) :
+                container_(container), file_(options) {
+    if (container != "mp4" && container != "mkv") {
+        throw std::invalid_argument("not support container: " + container);
+    }
+}
+
+
+ContainerSegmentWriter::~ContainerSegmentWriter() {
+    close();
+}
+
+
+const char* ContainerSegmentWriter::extension() const {
+    return container_ == "mp4" ? ".mp4" : ".mkv";
+}
+
+
+int ContainerSegmentWriter::open(const std::string& path, const SegmentStream& stream) {
+    const char* format = (container_ == "mp4") ? "mp4" : "matroska";
+    int ret = avformat_alloc_output_context2(&fmt_ctx_, nullptr, format, path.c_str());
+    if (ret < 0 || !fmt_ctx_) {
+        std::cerr << "avformat_alloc_output_context2 failed: " << ret << std::endl;
+        return -1;
+    }
+    AVStream* st = avformat_new_stream(fmt_ctx_, nullptr);
+    if (!st) {
+        std::cerr << "avformat_new_stream failed" << std::endl;
+        close();
+        return -1;
+    }
+    if ((ret = avcodec_parameters_copy(st->codecpar, stream.par.get())) < 0) {
+        std::cerr << "avcodec_parameters_copy failed: " << ret << std::endl;
+        close();
+        return ret;
+    }
+    codec_time_base_ = stream.time_base;
+    st->time_base = stream.time_base;
+    st->avg_frame_rate = stream.frame_rate;
+    st->r_frame_rate = stream.frame_rate;
+
+    if (file_.open(path) < 0) {
+        close();
+        return -1;
+    }
+    path_ = path;  // 此后打开失败时已创建的文件同样通知监听者
+    // 由 BufferedFile 负责批量写出, AVIO 缓冲区只需容纳单次写入
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(AVIO_BUFFER_SIZE));
+    fmt_ctx_->pb = buffer ? avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 1, &file_,
+                                               nullptr, avio_write_packet, avio_seek) : nullptr;
+    if (!fmt_ctx_->pb) {
+        std::cerr << "avio_alloc_context failed" << std::endl;
+        av_free(buffer);
+        close();
+        return -1;
+    }
+    fmt_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    AVDictionary* opts = nullptr;
+    if (container_ == "mp4") {
+        // 关键帧处分片, moov 在文件头且不含样本, 写入中断时已完成的分片仍可解析
+        av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    }
+    ret = avformat_write_header(fmt_ctx_, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "avformat_write_header failed: " << ret << std::endl;
+        close();
+        return ret;
+    }
+    header_written_ = true;
+    return 0;
+}
+
+
+int ContainerSegmentWriter::write(AVPacket* pkt) {
+    AVStream* stream = fmt_ctx_->streams[0];
+    pkt->stream_index = stream->index;
+    av_packet_rescale_ts(pkt, codec_time_base_, stream->time_base);
+    // 单路流无需交错, 直接写出
+    int ret = av_write_frame(fmt_ctx_, pkt);
+    if (ret < 0) {
+        std::cerr << "av_write_frame failed: " << ret << std::endl;
+    }
+    return ret;
+}
+
+
+void ContainerSegmentWriter::flush() {
+    if (fmt_ctx_ && fmt_ctx_->pb) {
+        avio_flush(fmt_ctx_->pb);
+        file_.flush();
+    }
+}
+
+
+int ContainerSegmentWriter::close() {
+    if (!fmt_ctx_) {
+        return 0;
+    }
+    int ret = 0;
+    if (header_written_) {
+        ret = av_write_trailer(fmt_ctx_);  // 写入索引
+    }
+    if (fmt_ctx_->pb) {
+        avio_flush(fmt_ctx_->pb);
+        av_freep(&fmt_ctx_->pb->buffer);
+        avio_context_free(&fmt_ctx_->pb);
+    }
+    avformat_free_context(fmt_ctx_);
+    fmt_ctx_ = nullptr;
+    header_written_ = false;
+    if (file_.close() < 0) {
+        ret = -1;
+    }
+    if (!path_.empty()) {
+        notify_closed(path_);
+        path_.clear();
+    }
+    return ret;
+}
+
+
+bool segment_container_supported(const std::string& container) {
+    return container == "raw" || container == "mp4" || container == "mkv";
+}
+
+
+std::unique_ptr<SegmentWriter> make_segment_writer(const std::string& container, const WriterOptions& options) {
+    if (container == "raw") {
+        return std::make_unique<RawSegmentWriter>(options);
+    }
+    if (container == "mp4" || container == "mkv") {
+        return std::make_unique<ContainerSegmentWriter>(container, options);
+    }
+    return nullptr;
+}
@@ -0,0 +1,75 @@
+
+#include <iostream>
+#include <algorithm>
+
+#include "speed_controller.h"
+
+
+SpeedController::SpeedController(const EncoderSettings& base) : base_(base) {
+    base_preset_ = preset_level(base.preset);
+    const CodecBackend* backend = find_codec_backend(base.codec);
+    if (backend) {
+        base_crf_ = backend->default_crf;
+        max_crf_ = std::max(backend->max_crf, base_crf_);
+    }
+    if (base.crf >= 0) {
+        base_crf_ = base.crf;
+        max_crf_ = std::max(max_crf_, base_crf_);
+    }
+}
+
+
+void SpeedController::record(int64_t cost_ms, size_t queue_depth) {
+    total_cost_ms_ += cost_ms;
+    max_depth_ = std::max(max_depth_, queue_depth);
+    frames_++;
+}
+
+
+std::optional<EncoderSettings> SpeedController::update(const EncoderSettings& current, size_t queue_capacity) {
+    if (frames_ == 0) {
+        return std::nullopt;
+    }
+    double avg_cost = static_cast<double>(total_cost_ms_) / frames_;
+    double fill = queue_capacity ? static_cast<double>(max_depth_) / queue_capacity : 0;
+    double interval = 1000.0 / current.fps;
+    total_cost_ms_ = 0;
+    max_depth_ = 0;
+    frames_ = 0;
+
+    bool overload = avg_cost > interval * OVERLOAD_RATIO || fill > OVERLOAD_DEPTH;
+    bool idle = avg_cost < interval * IDLE_RATIO && fill < IDLE_DEPTH;
+    if (!overload && !idle) {
+        return std::nullopt;
+    }
+
+    EncoderSettings next = current;
+    int preset = preset_level(current.preset);
+    bool adjust_crf = (current.qp < 0);  // 固定 QP 模式下不调整 CRF
+    double crf = (current.crf >= 0) ? current.crf : base_crf_;
+    if (overload) {
+        if (base_preset_ >= 0 && preset > 0) {
+            next.preset = preset_name(preset - 1);
+        } else if (adjust_crf && crf < max_crf_) {
+            next.crf = std::min(crf + CRF_STEP, max_crf_);
+        } else {
+            return std::nullopt;
+        }
+    } else {
+        // 先恢复画质, 再恢复速度档位
+        if (adjust_crf && current.crf >= 0 && crf > base_crf_) {
+            next.crf = std::max(crf - CRF_STEP, base_crf_);
+            if (next.crf == base_crf_ && base_.crf < 0) {
+                next.crf = -1;
+            }
+        } else if (base_preset_ >= 0 && preset >= 0 && preset < base_preset_) {
+            next.preset = preset_name(preset + 1);
+        } else {
+            return std::nullopt;
+        }
+    }
+    std::cout << "speed control: avg cost " << avg_cost << " ms, queue fill " << fill
+              << "; preset " << current.preset << " -> " << next.preset
+              << ", crf " << current.crf << " -> " << next.crf << std::endl;
+    return next;
+}
@@ -0,0 +1,103 @@
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "spill_file.h"
+
+
+SpillFile::SpillFile(const std::string& path, size_t capacity) : capacity_(capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("spill capacity must be greater than 0");
+    }
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd_ < 0) {
+        throw std::runtime_error("could not open spill file " + path + ": " + strerror(errno));
+    }
+    unlink(path.c_str());  // 只保留文件描述符, 不在目录中留下暂存文件
+    if (ftruncate(fd_, capacity) != 0) {
+        close(fd_);
+        throw std::runtime_error("could not resize spill file: " + std::string(strerror(errno)));
+    }
+    void* addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error("could not map spill file: " + std::string(strerror(errno)));
+    }
+    map_ = static_cast<uint8_t*>(addr);
+}
+
+
+SpillFile::~SpillFile() {
+    if (map_) munmap(map_, capacity_);
+    if (fd_ >= 0) close(fd_);
+}
+
+
+/**
+ * 写入一帧, 尾部空间不足时回绕到文件起始处
+ * 数据区间: 未回绕时为 [head, tail_), 回绕后为 [head, 末尾) 与 [0, tail_)
+ */
+bool SpillFile::write(const FrameItem& item) {
+    const cv::Mat& mat = item.mat;
+    size_t row_bytes = mat.cols * mat.elemSize();
+    size_t bytes = row_bytes * mat.rows;
+    if (bytes == 0 || bytes > capacity_) {
+        return false;
+    }
+    size_t offset;
+    if (records_.empty()) {
+        offset = 0;
+    } else {
+        size_t head = records_.front().offset;
+        if (tail_ > head) {
+            if (capacity_ - tail_ >= bytes) {
+                offset = tail_;
+            } else if (head >= bytes) {
+                offset = 0;
+            } else {
+                return false;
+            }
+        } else if (head - tail_ >= bytes) {
+            offset = tail_;
+        } else {
+            return false;
+        }
+    }
+    if (mat.isContinuous()) {
+        memcpy(map_ + offset, mat.data, bytes);
+    } else {
+        for (int i = 0; i < mat.rows; i++) {
+            memcpy(map_ + offset + i * row_bytes, mat.ptr(i), row_bytes);
+        }
+    }
+    records_.push_back({offset, bytes, mat.rows, mat.cols, mat.type(), item.enqueue_us, item.rois});
+    tail_ = offset + bytes;
+    return true;
+}
+
+
+std::optional<FrameItem> SpillFile::read() {
+    if (records_.empty()) {
+        return std::nullopt;
+    }
+    const Record& rec = records_.front();
+    cv::Mat mat(rec.rows, rec.cols, rec.type);
+    memcpy(mat.data, map_ + rec.offset, rec.bytes);
+    FrameItem item(std::move(mat));
+    item.enqueue_us = rec.enqueue_us;
+    item.rois = std::move(records_.front().rois);
+    records_.pop_front();
+    if (records_.empty()) {
+        tail_ = 0;
+    }
+    return item;
+}
+
+
+size_t SpillFile::front_bytes() const {
+    return records_.empty() ? 0 : records_.front().bytes;
+}
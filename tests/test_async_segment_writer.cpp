@@ -0,0 +1,116 @@
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_segment_writer.h"
+
+
+/**
+ * AsyncSegmentWriter 测试
+ *   包按提交顺序写出, 调用方的包在 write 后被取走
+ *   关闭通知在 I/O 线程中关闭完成后发出, 带绝对路径与磁盘上的文件大小
+ *   打开失败的分段不通知, 错误在之后的调用中返回
+ *   打开分段后 I/O 线程空闲时预先创建下一个分段的文件
+ */
+
+namespace fs = std::filesystem;
+
+struct Closed {
+    std::string path;
+    int64_t bytes;
+    std::thread::id thread;
+};
+
+
+static std::vector<uint8_t> write_segment(AsyncSegmentWriter& writer, const std::string& path, int packets) {
+    std::vector<uint8_t> written;
+    assert(writer.open(path, SegmentStream()) == 0);
+    for (int i = 0; i < packets; i++) {
+        AVPacket* pkt = av_packet_alloc();
+        assert(pkt && av_new_packet(pkt, i % 300 + 1) == 0);
+        memset(pkt->data, i, pkt->size);
+        written.insert(written.end(), pkt->data, pkt->data + pkt->size);
+        assert(writer.write(pkt) == 0);
+        assert(pkt->data == nullptr);  // 引用已转移
+        av_packet_free(&pkt);
+        if (i % 1000 == 0) {
+            writer.flush();
+        }
+    }
+    assert(writer.close() == 0);
+    return written;
+}
+
+
+static bool has_spare(const fs::path& dir) {
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().filename().string().rfind(".next_", 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+
+int main() {
+    fs::path dir = fs::absolute("test_async_segment_writer.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::mutex mtx;
+    std::vector<Closed> closed;
+    {
+        AsyncSegmentWriter writer(make_segment_writer("raw"));
+        writer.set_close_listener([&](const std::string& path, int64_t bytes) {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed.push_back({path, bytes, std::this_thread::get_id()});
+        });
+        std::string first = (dir / "1.h264").string();
+        std::string second = (dir / "2.h264").string();
+        std::vector<uint8_t> a = write_segment(writer, first, 5000);
+        std::vector<uint8_t> b = write_segment(writer, second, 10);
+        assert(writer.wait() == 0);
+        assert(read_file(first) == a && read_file(second) == b);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            assert(closed.size() == 2);
+            assert(closed[0].path == first && closed[0].bytes == static_cast<int64_t>(a.size()));
+            assert(closed[1].path == second && closed[1].bytes == static_cast<int64_t>(b.size()));
+            assert(closed[0].thread != std::this_thread::get_id());
+        }
+        bool prepared = false;
+        for (int i = 0; i < 200 && !prepared; i++) {
+            prepared = has_spare(dir);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(prepared);
+
+        // 打开失败: 错误由 open 或之后的 wait 返回, 不通知
+        int open_ret = writer.open((dir / "missing" / "3.h264").string(), SegmentStream());
+        int wait_ret = writer.wait();
+        assert((open_ret < 0) != (wait_ret < 0));
+        writer.close();
+        assert(writer.wait() == 0);
+        std::lock_guard<std::mutex> lock(mtx);
+        assert(closed.size() == 2);
+    }
+
+    fs::remove_all(dir);
+    printf("async segment writer tests passed\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "buffered_file.h"
+
+
+/**
+ * BufferedFile 测试
+ *   写入的数据与文件内容一致, 关闭后文件截断到实际大小
+ *   打开时不创建预备文件, prepare_spare 之后才创建, 下次打开时重命名为新文件
+ *   首次打开目录时删除已退出进程遗留的预备文件, 保留运行中进程的预备文件与其他文件
+ */
+
+namespace fs = std::filesystem;
+
+
+static std::vector<fs::path> spares(const fs::path& dir) {
+    std::vector<fs::path> found;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().filename().string().rfind(".next_", 0) == 0) {
+            found.push_back(entry.path());
+        }
+    }
+    return found;
+}
+
+
+static std::vector<uint8_t> read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+
+static void touch(const fs::path& path) {
+    std::ofstream(path).put('x');
+}
+
+
+/**
+ * 已退出的进程号: 子进程退出并回收后, 在短时间内不会被复用
+ */
+static pid_t exited_pid() {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        _exit(0);
+    }
+    waitpid(pid, nullptr, 0);
+    return pid;
+}
+
+
+static void test_spare(const fs::path& dir) {
+    WriterOptions options;
+    options.buffer_size = 4096;
+    options.preallocate_bytes = 1 << 20;
+    BufferedFile file(options);
+
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 31);
+    }
+    assert(file.open((dir / "1.h264").string()) == 0);
+    assert(spares(dir).empty());  // 预备文件不在打开的路径上创建
+    file.prepare_spare();
+    std::vector<fs::path> prepared = spares(dir);
+    assert(prepared.size() == 1);
+    file.prepare_spare();         // 每次打开后只准备一次
+    assert(spares(dir) == prepared);
+
+    assert(file.write(data.data(), data.size()) == 0);
+    assert(file.close() == 0);
+    assert(read_file(dir / "1.h264") == data);
+
+    // 下次打开使用预备文件, 关闭时截断掉多余的预分配空间
+    assert(file.open((dir / "2.h264").string()) == 0);
+    assert(spares(dir).empty());
+    assert(file.write(data.data(), 100) == 0);
+    assert(file.close() == 0);
+    assert(fs::file_size(dir / "2.h264") == 100);
+
+    // 没有准备时正常创建
+    assert(file.open((dir / "3.h264").string()) == 0);
+    assert(file.close() == 0);
+    assert(fs::exists(dir / "3.h264") && fs::file_size(dir / "3.h264") == 0);
+}
+
+
+static void test_no_preopen(const fs::path& dir) {
+    WriterOptions options;
+    options.preopen = false;
+    BufferedFile file(options);
+    assert(file.open((dir / "4.h264").string()) == 0);
+    file.prepare_spare();
+    assert(spares(dir).empty());
+    assert(file.close() == 0);
+}
+
+
+static void test_stale_spares(const fs::path& dir) {
+    fs::path stale = dir / (".next_" + std::to_string(exited_pid()) + "_1.tmp");
+    fs::path own = dir / (".next_" + std::to_string(getpid()) + "_2.tmp");
+    fs::path other = dir / ".next_abc.tmp";
+    touch(stale);
+    touch(own);
+    touch(other);
+
+    BufferedFile file{WriterOptions()};
+    assert(file.open((dir / "5.h264").string()) == 0);
+    assert(!fs::exists(stale));
+    assert(fs::exists(own) && fs::exists(other));
+    assert(file.close() == 0);
+}
+
+
+int main() {
+    fs::path dir = fs::absolute("test_buffered_file.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    test_spare(dir);
+    test_no_preopen(dir);
+    test_stale_spares(dir);
+    fs::remove_all(dir);
+    printf("buffered file tests passed\n");
+    return 0;
+}
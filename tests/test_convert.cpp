@@ -0,0 +1,202 @@
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include "convert_simd.h"
+
+
+/**
+ * BGR24 -> I420 内核测试
+ *   向量化实现 (ssse3/avx2) 与标量实现逐字节一致
+ *   与被替换的 swscale (SWS_BILINEAR) 路径相比, Y 与 U/V 的最大差值不超过容差
+ * 覆盖宽高为奇数、宽度不是 16/32 的整数倍、行跨度带填充的图像
+ */
+
+static const int MAX_DIFF_Y = 2;   // 系数精度与舍入不同
+static const int MAX_DIFF_UV = 4;  // 另含色度下采样滤波不同 (2x2 均值 / swscale 插值)
+
+enum class Pattern {
+    Noise,   // 逐像素随机, 只比较与滤波无关的部分
+    Smooth,  // 随机低频内容, 色度下采样方式的差异有界
+    Flat,    // 单一颜色
+};
+
+
+struct Image {
+    int width;
+    int height;
+    int stride;
+    std::vector<uint8_t> bgr;
+};
+
+
+struct Planes {
+    int width;
+    int height;
+    std::vector<uint8_t> y, u, v;
+    int stride_y, stride_uv;
+
+    Planes(int w, int h) : width(w), height(h) {
+        // 目标行跨度同样带填充, 检查是否越界写入由填充字节的哨兵值判断
+        stride_y = w + 7;
+        stride_uv = (w + 1) / 2 + 5;
+        y.assign(static_cast<size_t>(stride_y) * h, 0xAA);
+        u.assign(static_cast<size_t>(stride_uv) * ((h + 1) / 2), 0xAA);
+        v.assign(static_cast<size_t>(stride_uv) * ((h + 1) / 2), 0xAA);
+    }
+};
+
+
+static Image make_image(int width, int height, int padding, Pattern pattern, std::mt19937& rng) {
+    Image img{width, height, width * 3 + padding, {}};
+    img.bgr.resize(static_cast<size_t>(img.stride) * height);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (auto& b : img.bgr) {
+        b = static_cast<uint8_t>(byte(rng));
+    }
+    if (pattern == Pattern::Flat) {
+        uint8_t color[3] = {static_cast<uint8_t>(byte(rng)), static_cast<uint8_t>(byte(rng)), static_cast<uint8_t>(byte(rng))};
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < 3; c++) {
+                    img.bgr[static_cast<size_t>(y) * img.stride + 3 * x + c] = color[c];
+                }
+            }
+        }
+    } else if (pattern == Pattern::Smooth) {
+        // CELL 像素一格的随机网格, 双线性插值
+        const int CELL = 32;
+        int gw = width / CELL + 2;
+        int gh = height / CELL + 2;
+        std::vector<int> grid(static_cast<size_t>(gw) * gh * 3);
+        for (auto& g : grid) {
+            g = byte(rng);
+        }
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int gx = x / CELL, gy = y / CELL;
+                double fx = (x % CELL) / static_cast<double>(CELL);
+                double fy = (y % CELL) / static_cast<double>(CELL);
+                for (int c = 0; c < 3; c++) {
+                    auto at = [&](int i, int j) { return grid[(static_cast<size_t>(j) * gw + i) * 3 + c]; };
+                    double top = at(gx, gy) * (1 - fx) + at(gx + 1, gy) * fx;
+                    double bottom = at(gx, gy + 1) * (1 - fx) + at(gx + 1, gy + 1) * fx;
+                    img.bgr[static_cast<size_t>(y) * img.stride + 3 * x + c] =
+                        static_cast<uint8_t>(top * (1 - fy) + bottom * fy + 0.5);
+                }
+            }
+        }
+    }
+    return img;
+}
+
+
+static Planes convert_kernel(Bgr24ToI420Func func, const Image& img) {
+    Planes out(img.width, img.height);
+    func(img.bgr.data(), img.stride,
+         out.y.data(), out.stride_y, out.u.data(), out.stride_uv, out.v.data(), out.stride_uv,
+         img.width, img.height);
+    return out;
+}
+
+
+static Planes convert_swscale(const Image& img) {
+    Planes out(img.width, img.height);
+    SwsContext* ctx = sws_getContext(img.width, img.height, AV_PIX_FMT_BGR24,
+                                     img.width, img.height, AV_PIX_FMT_YUV420P,
+                                     SWS_BILINEAR, nullptr, nullptr, nullptr);
+    assert(ctx);
+    const uint8_t* src[4] = {img.bgr.data(), nullptr, nullptr, nullptr};
+    int src_stride[4] = {img.stride, 0, 0, 0};
+    uint8_t* dst[4] = {out.y.data(), out.u.data(), out.v.data(), nullptr};
+    int dst_stride[4] = {out.stride_y, out.stride_uv, out.stride_uv, 0};
+    int ret = sws_scale(ctx, src, src_stride, 0, img.height, dst, dst_stride);
+    assert(ret == img.height);
+    sws_freeContext(ctx);
+    return out;
+}
+
+
+/**
+ * 比较一个平面的有效区域, 返回最大差值; 同时检查填充字节未被改写
+ */
+static int plane_diff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                      int width, int height, int stride, bool check_padding) {
+    int max_diff = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < stride; x++) {
+            size_t i = static_cast<size_t>(y) * stride + x;
+            if (x >= width) {
+                if (check_padding) {
+                    assert(a[i] == 0xAA);
+                }
+                continue;
+            }
+            max_diff = std::max(max_diff, std::abs(a[i] - b[i]));
+        }
+    }
+    return max_diff;
+}
+
+
+static void compare(const char* name, const Image& img, const Planes& got, const Planes& ref,
+                    int max_y, int max_uv, bool check_uv, bool check_padding) {
+    int cw = (img.width + 1) / 2;
+    int ch = (img.height + 1) / 2;
+    int dy = plane_diff(got.y, ref.y, img.width, img.height, got.stride_y, check_padding);
+    int du = plane_diff(got.u, ref.u, cw, ch, got.stride_uv, check_padding);
+    int dv = plane_diff(got.v, ref.v, cw, ch, got.stride_uv, check_padding);
+    if (dy > max_y || (check_uv && (du > max_uv || dv > max_uv))) {
+        fprintf(stderr, "%s %dx%d stride %d: max diff y=%d u=%d v=%d (limit y=%d uv=%d)\n",
+                name, img.width, img.height, img.stride, dy, du, dv, max_y, max_uv);
+        assert(false);
+    }
+}
+
+
+int main() {
+    std::mt19937 rng(12345);
+    const int sizes[][2] = {
+        {1, 1}, {2, 2}, {3, 1}, {5, 3}, {15, 4}, {16, 2}, {17, 3}, {31, 5},
+        {32, 8}, {33, 7}, {47, 9}, {63, 2}, {64, 64}, {95, 33}, {640, 480}, {641, 481},
+    };
+    const int paddings[] = {0, 1, 13};
+    const char* kernels[] = {"ssse3", "avx2"};
+
+    Bgr24ToI420Func scalar = find_bgr24_to_i420("c");
+    assert(scalar);
+    int cases = 0;
+    for (const auto& size : sizes) {
+        for (int padding : paddings) {
+            for (Pattern pattern : {Pattern::Noise, Pattern::Smooth, Pattern::Flat}) {
+                Image img = make_image(size[0], size[1], padding, pattern, rng);
+                Planes ref = convert_kernel(scalar, img);
+                // 向量化实现与标量实现一致
+                for (const char* name : kernels) {
+                    Bgr24ToI420Func func = find_bgr24_to_i420(name);
+                    if (func) {
+                        compare(name, img, convert_kernel(func, img), ref, 0, 0, true, true);
+                    }
+                }
+                // 与 swscale 相比: 逐像素随机的图像只比较亮度
+                compare("swscale", img, ref, convert_swscale(img),
+                        MAX_DIFF_Y, MAX_DIFF_UV, pattern != Pattern::Noise, false);
+                cases++;
+            }
+        }
+    }
+    for (const char* name : kernels) {
+        printf("%s: %s\n", name, find_bgr24_to_i420(name) ? "tested" : "not supported by cpu, skipped");
+    }
+    printf("%d cases passed\n", cases);
+    return 0;
+}
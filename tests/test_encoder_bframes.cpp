@@ -0,0 +1,108 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "encoder.h"
+#include "utils.h"
+
+
+/**
+ * 有 B 帧时编码输出包不按 pts 顺序, 检查每个包都能取回对应帧的入队时刻:
+ *   延迟统计覆盖全部帧, 分段目录中关键帧与分段结束的采集时刻与帧对应
+ * 以及分段关闭后的通知带磁盘上的文件大小
+ * 需要 libx264, 本地 FFmpeg 未编译时跳过
+ */
+
+namespace fs = std::filesystem;
+
+static const int WIDTH = 128;
+static const int HEIGHT = 96;
+static const int FRAMES = 40;
+static const int GOP = 10;
+static const int64_t FRAME_US = 100000;
+static const int64_t TOLERANCE_US = 20000;  // 系统时钟与单调时钟换算的误差
+
+
+static AVFrame* make_frame(int n, int64_t enqueue_us) {
+    AVFrame* frame = av_frame_alloc();
+    assert(frame);
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = WIDTH;
+    frame->height = HEIGHT;
+    assert(av_frame_get_buffer(frame, 0) == 0);
+    for (int plane = 0; plane < 3; plane++) {
+        int w = plane ? WIDTH / 2 : WIDTH;
+        int h = plane ? HEIGHT / 2 : HEIGHT;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                frame->data[plane][y * frame->linesize[plane] + x] = static_cast<uint8_t>(x * 2 + y + n * 3 + plane * 50);
+            }
+        }
+    }
+    frame->pts = n;
+    frame->opaque = reinterpret_cast<void*>(static_cast<intptr_t>(enqueue_us));
+    return frame;
+}
+
+
+int main() {
+    if (!avcodec_find_encoder_by_name("libx264")) {
+        printf("libx264 not compiled into ffmpeg, skipped\n");
+        return 0;
+    }
+    fs::path dir = fs::absolute("test_encoder_bframes.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string segment = (dir / "0.h264").string();
+
+    auto catalog = std::make_shared<SegmentCatalog>((dir / "catalog").string());
+    std::vector<std::pair<std::string, int64_t>> closed;
+    EncoderSettings settings;
+    settings.preset = "veryfast";
+    settings.gop = GOP;
+    settings.bframes = 2;
+    settings.segment_frames = 0;
+    Encoder encoder(WIDTH, HEIGHT);
+    assert(encoder.set_settings(settings) == 0);
+    encoder.set_catalog(catalog);
+    encoder.set_segment_listener([&closed](const std::string& path, int64_t bytes) {
+        closed.emplace_back(path, bytes);
+    });
+    assert(encoder.init() == 0);
+
+    // 入队时刻按帧间隔递增, 换算为系统时钟后应为 wall_base + n * FRAME_US
+    int64_t mono_base = get_time_us();
+    int64_t wall_base = get_wall_time_us() - get_time_us() + mono_base;
+    assert(encoder.open_segment(segment) == 0);
+    for (int n = 0; n < FRAMES; n++) {
+        AVFrame* frame = make_frame(n, mono_base + n * FRAME_US);
+        assert(encoder.write_frame(frame) == 0);
+        av_frame_free(&frame);
+    }
+    assert(encoder.close_segment() == 0);
+    encoder.encode_end();
+
+    assert(encoder.encoded_frames() == FRAMES);
+    assert(encoder.latency().count == FRAMES);  // 每个输出包都取回了入队时刻
+
+    assert(catalog->segment_count() == 1);
+    for (int n = 0; n < FRAMES; n++) {
+        auto entry = catalog->lookup(wall_base + n * FRAME_US + FRAME_US / 2);
+        assert(entry && entry->file == segment);
+        assert(entry->pts <= n && n - entry->pts < GOP);
+        assert(std::llabs(entry->capture_us - (wall_base + entry->pts * FRAME_US)) < TOLERANCE_US);
+        assert(std::llabs(entry->segment_end_us - (wall_base + (FRAMES - 1) * FRAME_US)) < TOLERANCE_US);
+    }
+
+    assert(closed.size() == 1);
+    assert(closed[0].first == segment && closed[0].second == static_cast<int64_t>(fs::file_size(segment)));
+    assert(closed[0].second > 0);
+
+    fs::remove_all(dir);
+    printf("encoder b-frame tests passed\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <regex>
+
+#include "encoder.h"
+
+
+/**
+ * 编码参数校验测试: set_settings 拒绝无效组合, reconfigure 拒绝运行中不能修改的参数
+ * 以及自动切分的分段文件名: 带毫秒时间戳与序号, 设置目录后位于该目录中
+ */
+
+static int apply(EncoderSettings settings) {
+    Encoder encoder(64, 64);
+    return encoder.set_settings(settings);
+}
+
+
+int main() {
+    EncoderSettings s;
+    assert(apply(s) == 0);
+
+    for (const char* codec : {"libx264", "h264", "hevc", "libx265", "av1", "libsvtav1", "libaom-av1"}) {
+        EncoderSettings t = s;
+        t.codec = codec;
+        assert(apply(t) == 0);
+    }
+    for (const char* container : {"raw", "mp4", "mkv"}) {
+        EncoderSettings t = s;
+        t.container = container;
+        assert(apply(t) == 0);
+    }
+
+    EncoderSettings t = s;
+    t.codec = "mpeg2video";
+    assert(apply(t) < 0);
+    t = s;
+    t.container = "avi";
+    assert(apply(t) < 0);
+    t = s;
+    t.fps = 0;
+    assert(apply(t) < 0);
+    t = s;
+    t.gop = 0;
+    assert(apply(t) < 0);
+    t = s;
+    t.bframes = -1;
+    assert(apply(t) < 0);
+    t = s;
+    t.io_buffer_kb = 0;
+    assert(apply(t) < 0);
+    t = s;
+    t.segment_seconds = -1;
+    assert(apply(t) < 0);
+    t = s;
+    t.crf = 23;
+    t.qp = 20;
+    assert(apply(t) < 0);  // crf 与 qp 不能同时设置
+
+    // 运行中只允许修改码率控制、preset 等, 不允许修改帧率、编码器、封装与写出参数
+    Encoder encoder(64, 64);
+    assert(encoder.set_settings(s) == 0);
+    t = s;
+    t.preset = "veryfast";
+    t.crf = 28;
+    assert(encoder.reconfigure(t) == 0);
+    t = s;
+    t.fps = 25;
+    assert(encoder.reconfigure(t) < 0);
+    t = s;
+    t.codec = "hevc";
+    assert(encoder.reconfigure(t) < 0);
+    t = s;
+    t.container = "mp4";
+    assert(encoder.reconfigure(t) < 0);
+    t = s;
+    t.async_io = !s.async_io;
+    assert(encoder.reconfigure(t) < 0);
+
+    // 分段文件名
+    namespace fs = std::filesystem;
+    Encoder named(64, 64);
+    named.set_segment_suffix("320x240");
+    std::string first = named.segment_name();
+    std::string second = named.segment_name();
+    assert(first != second);
+    assert(std::regex_match(first, std::regex(R"(\d{13}_\d+_320x240\.h264)")));
+    named.set_segment_dir("segments");
+    fs::path in_dir = named.segment_name();
+    assert(in_dir.parent_path() == "segments");
+    assert(std::regex_match(in_dir.filename().string(), std::regex(R"(\d{13}_\d+_320x240\.h264)")));
+
+    printf("encoder settings tests passed\n");
+    return 0;
+}
@@ -0,0 +1,74 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+#include "frame_converter.h"
+
+
+/**
+ * FrameConverter 测试
+ *   yuv420p/nv12 输入的宽高必须为偶数, 否则 height * 3 / 2 行的 Mat 放不下色度平面
+ *   其他输入格式不限制宽高的奇偶
+ *   yuv420p 输入按平面复制到输出帧
+ */
+
+static bool constructs(int width, int height, AVPixelFormat format) {
+    try {
+        FrameConverter converter(width, height, format);
+    } catch (const std::invalid_argument&) {
+        return false;
+    }
+    return true;
+}
+
+
+static void test_dimensions() {
+    for (AVPixelFormat format : {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12}) {
+        assert(constructs(640, 480, format));
+        assert(!constructs(641, 480, format));
+        assert(!constructs(640, 481, format));
+        assert(!constructs(3, 3, format));
+    }
+    for (AVPixelFormat format : {AV_PIX_FMT_BGR24, AV_PIX_FMT_GRAY8}) {
+        assert(constructs(641, 481, format));
+    }
+    assert(!constructs(64, 64, AV_PIX_FMT_YUV444P));
+}
+
+
+static void test_yuv420p_copy() {
+    const int width = 34, height = 6;
+    FrameConverter converter(width, height, AV_PIX_FMT_YUV420P);
+    assert(converter.init() == 0);
+    assert(converter.input_rows() == height * 3 / 2 && converter.input_channels() == 1);
+    cv::Mat mat(converter.input_rows(), width, CV_8UC1);
+    for (int i = 0; i < converter.input_rows() * width; i++) {
+        mat.data[i] = static_cast<uint8_t>(i * 7);
+    }
+    AVFramePtr frame = converter.convert(mat);
+    assert(frame && frame->format == AV_PIX_FMT_YUV420P);
+    const uint8_t* src = mat.data;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            assert(frame->data[0][y * frame->linesize[0] + x] == src[y * width + x]);
+        }
+    }
+    src += width * height;
+    for (int plane = 1; plane <= 2; plane++) {
+        for (int y = 0; y < height / 2; y++) {
+            for (int x = 0; x < width / 2; x++) {
+                assert(frame->data[plane][y * frame->linesize[plane] + x] == src[y * (width / 2) + x]);
+            }
+        }
+        src += width / 2 * (height / 2);
+    }
+}
+
+
+int main() {
+    test_dimensions();
+    test_yuv420p_copy();
+    printf("frame converter tests passed\n");
+    return 0;
+}
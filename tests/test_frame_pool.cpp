@@ -0,0 +1,112 @@
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+#include "frame_pool.h"
+
+
+/**
+ * FramePool 测试
+ *   槽位状态: 取出 -> 提交 -> 处理完成后归还, 或取出后直接放弃
+ *   只有取出状态的槽位能提交或放弃; 重复提交、放弃已提交的槽位被拒绝, 槽位不会重复回到空闲列表
+ *   已提交的槽位只由 release_committed 归还, 之前不会被再次取出
+ *   槽位耗尽时 acquire 超时返回 -1, 归还或停止时唤醒等待者
+ */
+
+static void test_slot_states() {
+    FramePool pool(2, 8, 4, 3);
+    assert(pool.available() == 2 && pool.frame_bytes() == 8 * 4 * 3);
+    int a = pool.acquire();
+    int b = pool.acquire();
+    assert(a == 0 && b == 1 && pool.available() == 0);
+    assert(pool.is_acquired(a) && pool.is_acquired(b));
+
+    // 提交后不能再次提交或放弃
+    assert(pool.commit(a));
+    assert(!pool.is_acquired(a));
+    assert(!pool.commit(a));
+    assert(!pool.release(a));
+    assert(pool.available() == 0);
+    assert(pool.acquire(10) == -1);
+
+    // 处理完成后归还一次; 重复归还忽略
+    pool.release_committed(a);
+    assert(pool.available() == 1);
+    pool.release_committed(a);
+    assert(pool.available() == 1);
+
+    // 取出但未提交的槽位不能按已提交归还
+    pool.release_committed(b);
+    assert(pool.is_acquired(b) && pool.available() == 1);
+    assert(pool.release(b));
+    assert(!pool.release(b));
+    assert(!pool.commit(b));
+    assert(pool.available() == 2);
+
+    // 空闲或非法槽位
+    assert(!pool.commit(-1) && !pool.commit(2) && !pool.release(5));
+    bool thrown = false;
+    try {
+        pool.data(2);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+static void test_wait_for_slot() {
+    FramePool pool(1, 4, 4, 1);
+    int slot = pool.acquire();
+    assert(slot == 0 && pool.commit(slot));
+    std::thread finisher([&pool, slot] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pool.release_committed(slot);
+    });
+    assert(pool.acquire(2000) == slot);
+    finisher.join();
+
+    std::thread stopper([&pool] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pool.stop();
+    });
+    assert(pool.acquire() == -1);
+    stopper.join();
+}
+
+
+static void test_buffers() {
+    FramePool pool(3, 17, 5, 4);
+    for (int i = 0; i < pool.count(); i++) {
+        // 缓存行对齐, 槽位之间不重叠
+        assert(reinterpret_cast<uintptr_t>(pool.data(i)) % 64 == 0);
+        cv::Mat mat = pool.mat(i);
+        assert(mat.data == pool.data(i) && mat.rows == 5 && mat.cols == 17 && mat.channels() == 4);
+        for (int j = 0; j < i; j++) {
+            uint8_t* lo = std::min(pool.data(i), pool.data(j));
+            uint8_t* hi = std::max(pool.data(i), pool.data(j));
+            assert(static_cast<size_t>(hi - lo) >= pool.frame_bytes());
+        }
+    }
+    bool thrown = false;
+    try {
+        FramePool invalid(1, 4, 4, 2);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+int main() {
+    test_slot_states();
+    test_wait_for_slot();
+    test_buffers();
+    printf("frame pool tests passed\n");
+    return 0;
+}
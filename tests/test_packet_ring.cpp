@@ -0,0 +1,177 @@
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "packet_ring.h"
+#include "utils.h"
+
+
+/**
+ * PacketRing 测试
+ *   缓冲区为空时丢弃关键帧之前的包
+ *   按 GOP 整组淘汰: 保留时长与字节上限
+ *   导出从不晚于开始时刻的最近关键帧开始, 到结束时刻为止
+ *   结束时刻晚于调用时刻时等待后续包, 最多等到结束时刻之后一小段时间, 缓冲关闭后不再等待
+ *   结束时刻不晚于调用时刻时不等待, 导出到最新的包为止
+ * 包的数据为序号的单字节重复 PACKET_SIZE 次, raw 导出后由文件内容判断包含哪些包
+ */
+
+namespace fs = std::filesystem;
+
+static const int PACKET_SIZE = 10;
+static const int GOP = 5;
+static const int64_t INTERVAL_US = 100 * 1000;
+
+
+static void write_packet(PacketRing& ring, int index, int64_t capture_us, bool key) {
+    AVPacket* pkt = av_packet_alloc();
+    assert(pkt && av_new_packet(pkt, PACKET_SIZE) == 0);
+    memset(pkt->data, index, PACKET_SIZE);
+    pkt->pts = pkt->dts = index;
+    if (key) {
+        pkt->flags |= AV_PKT_FLAG_KEY;
+    }
+    ring.write(pkt, capture_us);
+    av_packet_free(&pkt);
+}
+
+
+/**
+ * 导出 raw 片段, 返回按顺序包含的包序号
+ */
+static std::vector<int> export_indices(PacketRing& ring, int64_t start_us, int64_t end_us, const fs::path& path) {
+    if (ring.export_clip(start_us, end_us, path.string(), "raw") < 0) {
+        return {};
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    assert(data.size() % PACKET_SIZE == 0);
+    std::vector<int> indices;
+    for (size_t i = 0; i < data.size(); i += PACKET_SIZE) {
+        indices.push_back(static_cast<unsigned char>(data[i]));
+    }
+    return indices;
+}
+
+
+static std::vector<int> range(int first, int last) {
+    std::vector<int> indices;
+    for (int i = first; i <= last; i++) {
+        indices.push_back(i);
+    }
+    return indices;
+}
+
+
+static void test_window_eviction_and_selection(const fs::path& dir) {
+    PacketRing ring(1.0);
+    ring.set_stream(SegmentStream());
+    int64_t base = get_time_us() - 10 * 1000 * 1000;  // 全部在过去, 导出不等待
+    write_packet(ring, 99, base - 1, false);  // 第一个关键帧之前, 丢弃
+    assert(ring.bytes() == 0);
+    for (int i = 0; i < 50; i++) {
+        write_packet(ring, i, base + i * INTERVAL_US, i % GOP == 0);
+    }
+    // 最新的包在 4.9 s; 关键帧 40 (4.0 s) 之后的部分不足 1 s, 保留 GOP 35 起的 15 个包
+    assert(ring.bytes() == 15 * PACKET_SIZE);
+    assert(export_indices(ring, base, base + 60 * INTERVAL_US, dir / "early.h264") == range(35, 49));
+
+    // 从开始时刻之前的最近关键帧开始, 包含结束时刻的包
+    assert(export_indices(ring, base + 42 * INTERVAL_US, base + 46 * INTERVAL_US, dir / "mid.h264") == range(40, 46));
+    // 开始时刻恰好为关键帧
+    assert(export_indices(ring, base + 45 * INTERVAL_US, base + 47 * INTERVAL_US, dir / "key.h264") == range(45, 47));
+    // 结束时刻在缓冲区之前
+    assert(export_indices(ring, base - 5 * INTERVAL_US, base - INTERVAL_US, dir / "none.h264").empty());
+}
+
+
+static void test_byte_limit() {
+    PacketRing ring(100.0, 25);
+    ring.set_stream(SegmentStream());
+    int64_t base = get_time_us();
+    for (int i = 0; i < 12; i++) {
+        write_packet(ring, i, base + i, i % GOP == 0);
+        // 只剩一个 GOP 时即使超出上限也保留
+        assert(ring.bytes() <= 25 || ring.bytes() == static_cast<size_t>(i % GOP + 1) * PACKET_SIZE);
+    }
+    // GOP 10 起的 2 个包
+    assert(ring.bytes() == 2 * PACKET_SIZE);
+}
+
+
+static void test_wait_for_end(const fs::path& dir) {
+    PacketRing ring(10.0);
+    ring.set_stream(SegmentStream());
+    int64_t now = get_time_us();
+    write_packet(ring, 0, now - 200 * 1000, true);
+    std::thread producer([&ring] {
+        for (int i = 1; i < 10; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            write_packet(ring, i, get_time_us(), i % GOP == 0);
+        }
+        ring.close();
+    });
+    // 结束时刻约在第 5 个包之后, 最后一个包一定晚于结束时刻; 导出等到之后的包到达, 只包含结束时刻之前的包
+    int64_t end_us = now + 110 * 1000;
+    std::vector<int> indices = export_indices(ring, now - 300 * 1000, end_us, dir / "wait.h264");
+    assert(get_time_us() >= end_us);
+    producer.join();
+    assert(!indices.empty() && indices.size() < 10);
+    assert(indices == range(0, static_cast<int>(indices.size()) - 1));
+}
+
+
+static void test_no_wait(const fs::path& dir) {
+    PacketRing ring(10.0);
+    ring.set_stream(SegmentStream());
+    int64_t now = get_time_us();
+    for (int i = 0; i < 3; i++) {
+        write_packet(ring, i, now - (3 - i) * INTERVAL_US, i == 0);
+    }
+    // 结束时刻为当前时刻: 最新的包早于结束时刻也立即返回
+    int64_t start = get_time_us();
+    assert(export_indices(ring, now - 10 * INTERVAL_US, get_time_us(), dir / "now.h264") == range(0, 2));
+    assert(get_time_us() - start < 200 * 1000);
+
+    // 结束时刻在未来但没有新包: 等到结束时刻之后的宽限时间为止
+    start = get_time_us();
+    int64_t end_us = start + 100 * 1000;
+    assert(export_indices(ring, now - 10 * INTERVAL_US, end_us, dir / "late.h264") == range(0, 2));
+    int64_t waited = get_time_us() - start;
+    assert(get_time_us() >= end_us && waited < 2 * 1000 * 1000);
+}
+
+
+static void test_invalid_arguments() {
+    bool thrown = false;
+    try {
+        PacketRing ring(0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+int main() {
+    fs::path dir = fs::absolute("test_packet_ring.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    test_window_eviction_and_selection(dir);
+    test_byte_limit();
+    test_wait_for_end(dir);
+    test_no_wait(dir);
+    test_invalid_arguments();
+    fs::remove_all(dir);
+    printf("packet ring tests passed\n");
+    return 0;
+}
@@ -0,0 +1,236 @@
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "packet_sink.h"
+#include "utils.h"
+
+
+/**
+ * ThreadedPacketSink 测试 (经由 CallbackSink)
+ *   包按提交顺序交给回调, 采集时刻换算为系统时钟
+ *   接收方阻塞使队列满时丢弃, 并一直丢弃到下一个能入队的关键帧, 之后从完整的 GOP 继续
+ *   回调为空时构造失败
+ * 回调在第一个包处阻塞, 直到测试放行, 队列的占用由测试确定
+ *
+ * StreamSink 测试: 本地 TCP 服务接受 rtmp 连接后不响应握手, 推流线程阻塞在连接中
+ *   close 中断阻塞的连接并立即返回
+ *   rw_timeout 到期后放弃连接
+ */
+
+static const int MAX_PENDING = 4;
+static const int GOP = 5;
+
+
+struct Receiver {
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool blocked = true;  // 回调在放行前阻塞
+    std::vector<int64_t> pts;
+    std::vector<bool> keys;
+    std::vector<int64_t> capture_us;
+
+    void on_packet(AVPacketPtr pkt, int64_t capture) {
+        std::unique_lock<std::mutex> lock(mtx);
+        pts.push_back(pkt->pts);
+        keys.push_back(pkt->flags & AV_PKT_FLAG_KEY);
+        capture_us.push_back(capture);
+        cv.notify_all();
+        cv.wait(lock, [this] { return !blocked; });
+    }
+
+    void wait_received(size_t count) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this, count] { return pts.size() >= count; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        blocked = false;
+        cv.notify_all();
+    }
+};
+
+
+static void write_packet(PacketSink& sink, int index) {
+    AVPacket* pkt = av_packet_alloc();
+    assert(pkt && av_new_packet(pkt, 16) == 0);
+    memset(pkt->data, index, pkt->size);
+    pkt->pts = pkt->dts = index;
+    if (index % GOP == 0) {
+        pkt->flags |= AV_PKT_FLAG_KEY;
+    }
+    sink.write(pkt, get_time_us());
+    av_packet_free(&pkt);
+}
+
+
+static void test_drop_to_keyframe() {
+    Receiver receiver;
+    CallbackSink sink([&receiver](AVPacketPtr pkt, int64_t capture_us) {
+        receiver.on_packet(std::move(pkt), capture_us);
+    }, MAX_PENDING);
+    sink.set_stream(SegmentStream());
+
+    // 包 0 交给回调后阻塞, 包 1~4 占满队列
+    write_packet(sink, 0);
+    receiver.wait_received(1);
+    for (int i = 1; i <= 4; i++) {
+        write_packet(sink, i);
+    }
+    assert(sink.dropped() == 0);
+    // 队列满: 关键帧 5 丢弃, 之后一直丢弃到下一个关键帧; 关键帧 10 仍无法入队
+    for (int i = 5; i <= 10; i++) {
+        write_packet(sink, i);
+    }
+    assert(sink.dropped() == 6);
+
+    // 接收方恢复后, 非关键帧 11~14 仍被丢弃, 从关键帧 15 继续; 15~18 恰好放满队列
+    receiver.release();
+    receiver.wait_received(5);
+    for (int i = 11; i <= 18; i++) {
+        write_packet(sink, i);
+    }
+    sink.close();
+    assert(sink.dropped() == 10);
+
+    std::vector<int64_t> expected = {0, 1, 2, 3, 4, 15, 16, 17, 18};
+    assert(receiver.pts == expected);
+    for (size_t i = 1; i < receiver.pts.size(); i++) {
+        if (receiver.pts[i] != receiver.pts[i - 1] + 1) {
+            assert(receiver.keys[i]);
+        }
+    }
+    // 采集时刻为系统时钟
+    int64_t now = get_wall_time_us();
+    for (int64_t capture : receiver.capture_us) {
+        assert(capture <= now && now - capture < 60 * 1000 * 1000);
+    }
+}
+
+
+/**
+ * 只接受连接, 从不发送数据的 TCP 服务
+ */
+struct SilentServer {
+    int listen_fd = -1;
+    int port = 0;
+
+    SilentServer() {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(listen_fd >= 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        assert(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len) == 0);
+        assert(listen(listen_fd, 1) == 0);
+        assert(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+        port = ntohs(addr.sin_port);
+    }
+
+    ~SilentServer() {
+        ::close(listen_fd);
+    }
+
+    int accept_client() {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        assert(fd >= 0);
+        return fd;
+    }
+
+    // 丢弃握手数据直到对端关闭连接
+    static void wait_closed(int fd) {
+        char buf[4096];
+        while (recv(fd, buf, sizeof(buf), 0) > 0) {
+        }
+        ::close(fd);
+    }
+};
+
+
+static SegmentStream h264_stream() {
+    SegmentStream stream;
+    stream.par.reset(avcodec_parameters_alloc(), [](AVCodecParameters* par) {
+        avcodec_parameters_free(&par);
+    });
+    AVCodecParameters* par = stream.par.get();
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id = AV_CODEC_ID_H264;
+    par->width = 64;
+    par->height = 48;
+    // 带全局头时连接不需要从关键帧提取参数集
+    static const uint8_t avcc[] = {1, 0x42, 0, 0x1e, 0xff, 0xe0, 0};
+    par->extradata = static_cast<uint8_t*>(av_mallocz(sizeof(avcc) + AV_INPUT_BUFFER_PADDING_SIZE));
+    memcpy(par->extradata, avcc, sizeof(avcc));
+    par->extradata_size = sizeof(avcc);
+    stream.time_base = {1, 25};
+    stream.frame_rate = {25, 1};
+    return stream;
+}
+
+
+static void test_stream_close_interrupts() {
+    SilentServer server;
+    StreamSink sink("rtmp://127.0.0.1:" + std::to_string(server.port) + "/live/test", "",
+                    {{"rw_timeout", "60000000"}});
+    sink.set_stream(h264_stream());
+    write_packet(sink, 0);
+    int fd = server.accept_client();
+    // 推流线程阻塞在 rtmp 握手, rw_timeout 远长于测试时间
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int64_t start = get_time_us();
+    sink.close();
+    assert(get_time_us() - start < 2 * 1000 * 1000);
+    SilentServer::wait_closed(fd);
+}
+
+
+static void test_stream_rw_timeout() {
+    SilentServer server;
+    StreamSink sink("rtmp://127.0.0.1:" + std::to_string(server.port) + "/live/test", "",
+                    {{"rw_timeout", "200000"}});
+    sink.set_stream(h264_stream());
+    write_packet(sink, 0);
+    int fd = server.accept_client();
+    // 握手超时后推流线程断开连接
+    int64_t start = get_time_us();
+    SilentServer::wait_closed(fd);
+    assert(get_time_us() - start < 3 * 1000 * 1000);
+    sink.close();
+}
+
+
+static void test_invalid_arguments() {
+    bool thrown = false;
+    try {
+        CallbackSink sink(nullptr);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+int main() {
+    test_drop_to_keyframe();
+    test_stream_close_interrupts();
+    test_stream_rw_timeout();
+    test_invalid_arguments();
+    printf("packet sink tests passed\n");
+    return 0;
+}
@@ -0,0 +1,163 @@
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "retention_manager.h"
+
+namespace fs = std::filesystem;
+
+
+/**
+ * RetentionManager 测试
+ *   启动时只接管 Encoder::segment_name 格式的文件, 其他文件不计入配额也不删除
+ *   超出字节上限时按修改时间由旧到新删除, 之前运行留下的分段排在新登记的分段之前
+ *   超出保留时长的分段被删除
+ *   只登记分段目录中的文件; 目录不存在时创建, 以绝对路径给出
+ *   未指定目录或配额时构造失败
+ */
+
+static fs::path make_file(const fs::path& dir, const std::string& name, size_t bytes, int age_seconds) {
+    fs::path path = dir / name;
+    std::ofstream(path, std::ios::binary) << std::string(bytes, 'x');
+    fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::seconds(age_seconds));
+    return path;
+}
+
+
+static bool wait_until(const std::function<bool()>& done, int timeout_ms = 3000) {
+    for (int waited = 0; waited < timeout_ms; waited += 10) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return done();
+}
+
+
+static void test_scan_and_byte_quota(const fs::path& dir) {
+    // 文件名顺序与修改时间顺序相反, 删除按修改时间
+    fs::path a = make_file(dir, "1700000000003_7.h264", 1000, 400);
+    fs::path b = make_file(dir, "1700000000002_6_640x360.mp4", 1000, 300);
+    fs::path c = make_file(dir, "1700000000001_5.h264", 1000, 200);
+    fs::path d = make_file(dir, "1700000000000_4.mkv", 1000, 100);
+    // 不是本程序生成的分段: 短数字名、旧格式、任意后缀、其他扩展名
+    fs::path others[] = {
+        make_file(dir, "123.mp4", 5000, 1000),
+        make_file(dir, "1700000000000.h264", 5000, 1000),
+        make_file(dir, "1700000000000_1_backup.mp4", 5000, 1000),
+        make_file(dir, "1700000000000_1.txt", 5000, 1000),
+    };
+
+    RetentionManager retention(dir.string(), 2500, 0);
+    retention.start();
+    assert(wait_until([&] { return retention.deleted() == 2; }));
+    assert(retention.total_bytes() == 2000);
+    assert(!fs::exists(a) && !fs::exists(b));
+    assert(fs::exists(c) && fs::exists(d));
+
+    // 新登记的分段排在已有分段之后
+    fs::path e = make_file(dir, "1800000000000_0.h264", 1000, 0);
+    retention.add(fs::absolute(e).string(), 1000);
+    assert(wait_until([&] { return retention.deleted() == 3; }));
+    assert(!fs::exists(c) && fs::exists(d) && fs::exists(e));
+    fs::path f = make_file(dir, "1800000000001_1.h264", 1000, 0);
+    retention.add(fs::absolute(f).string(), 1000);
+    assert(wait_until([&] { return retention.deleted() == 4; }));
+    assert(!fs::exists(d) && fs::exists(e) && fs::exists(f));
+    assert(retention.total_bytes() == 2000);
+    retention.stop();
+
+    for (const auto& path : others) {
+        assert(fs::exists(path));
+    }
+}
+
+
+static void test_age_quota(const fs::path& dir) {
+    fs::path old_segment = make_file(dir, "1700000000000_0.h264", 100, 3600);
+    RetentionManager retention(dir.string(), 0, 60);
+    retention.start();
+    assert(wait_until([&] { return retention.deleted() == 1; }));
+    assert(!fs::exists(old_segment));
+
+    // 新分段在保留时长内不删除
+    fs::path fresh = make_file(dir, "1800000000000_1.h264", 100, 0);
+    retention.add(fs::absolute(fresh).string(), 100);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(fs::exists(fresh) && retention.deleted() == 1);
+    retention.stop();
+}
+
+
+static void test_directory(const fs::path& dir) {
+    fs::path segments = dir / "segments";
+    RetentionManager retention(segments.string() + "/", 1000, 0);
+    assert(fs::is_directory(segments));
+    assert(retention.directory() == segments.string());
+
+    // 其他目录 (包括子目录与上级目录) 中的文件不计入配额, 也不会被删除
+    fs::create_directories(segments / "sub");
+    fs::path outside[] = {
+        make_file(dir, "1700000000000_0.h264", 5000, 0),
+        make_file(segments / "sub", "1700000000000_1.h264", 5000, 0),
+    };
+    retention.start();
+    for (const auto& path : outside) {
+        retention.add(path.string(), 5000);
+    }
+    assert(retention.total_bytes() == 0);
+
+    // 相对路径与带 .. 的路径按所在目录判断
+    fs::path inside = make_file(segments, "1700000000000_2.h264", 600, 0);
+    retention.add((segments / "sub" / ".." / inside.filename()).string(), 600);
+    assert(retention.total_bytes() == 600);
+    fs::path newer = make_file(segments, "1700000000000_3.h264", 600, 0);
+    retention.add(fs::relative(newer).string(), 600);
+    assert(wait_until([&] { return retention.deleted() == 1; }));
+    assert(!fs::exists(inside) && fs::exists(newer));
+    retention.stop();
+    for (const auto& path : outside) {
+        assert(fs::exists(path));
+    }
+}
+
+
+static void test_invalid_arguments() {
+    bool thrown = false;
+    try {
+        RetentionManager retention("", 1000, 0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    try {
+        RetentionManager retention("segments", 0, 0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+int main() {
+    fs::path dir = fs::absolute("test_retention_manager.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir / "bytes");
+    fs::create_directories(dir / "age");
+    test_scan_and_byte_quota(dir / "bytes");
+    test_age_quota(dir / "age");
+    test_directory(dir / "directory");
+    test_invalid_arguments();
+    fs::remove_all(dir);
+    printf("retention manager tests passed\n");
+    return 0;
+}
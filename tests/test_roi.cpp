@@ -0,0 +1,79 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include "frame_converter.h"
+
+
+/**
+ * 感兴趣区域附加测试
+ *   区域裁剪到图像范围内, 裁剪后为空的区域忽略, 顺序保持不变
+ *   qoffset 按 1/1000 换算为有理数; 没有有效区域时不附加 side data
+ */
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+
+
+static AVFrame* make_frame() {
+    AVFrame* frame = av_frame_alloc();
+    assert(frame);
+    frame->width = WIDTH;
+    frame->height = HEIGHT;
+    return frame;
+}
+
+
+static std::vector<AVRegionOfInterest> regions_of(AVFrame* frame) {
+    AVFrameSideData* side_data = av_frame_get_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    if (!side_data) {
+        return {};
+    }
+    assert(side_data->size % sizeof(AVRegionOfInterest) == 0);
+    const AVRegionOfInterest* begin = reinterpret_cast<const AVRegionOfInterest*>(side_data->data);
+    return std::vector<AVRegionOfInterest>(begin, begin + side_data->size / sizeof(AVRegionOfInterest));
+}
+
+
+static void expect_region(const AVRegionOfInterest& roi, int left, int top, int right, int bottom, int qoffset) {
+    assert(roi.self_size == sizeof(AVRegionOfInterest));
+    assert(roi.left == left && roi.top == top && roi.right == right && roi.bottom == bottom);
+    assert(roi.qoffset.num == qoffset && roi.qoffset.den == 1000);
+}
+
+
+int main() {
+    AVFrame* frame = make_frame();
+    std::vector<RoiRect> rois = {
+        {10, 20, 100, 50, -0.5f},                // 图像内
+        {-30, -40, 100, 100, 0.25f},             // 左上角超出
+        {600, 450, 100, 100, 1.0f},              // 右下角超出
+        {WIDTH, 0, 10, 10, -1.0f},               // 完全在图像右侧
+        {0, -20, 10, 20, -1.0f},                 // 完全在图像上方
+        {50, 50, 0, 10, -1.0f},                  // 宽度为 0
+        {0, 0, WIDTH, HEIGHT, -1.0f},            // 整幅图像
+    };
+    assert(attach_rois(frame, rois) == 0);
+    std::vector<AVRegionOfInterest> regions = regions_of(frame);
+    assert(regions.size() == 4);
+    expect_region(regions[0], 10, 20, 110, 70, -500);
+    expect_region(regions[1], 0, 0, 70, 60, 250);
+    expect_region(regions[2], 600, 450, WIDTH, HEIGHT, 1000);
+    expect_region(regions[3], 0, 0, WIDTH, HEIGHT, -1000);
+    av_frame_free(&frame);
+
+    // 没有有效区域时不附加
+    frame = make_frame();
+    assert(attach_rois(frame, {}) == 0);
+    assert(attach_rois(frame, {{-10, -10, 5, 5, -1.0f}}) == 0);
+    assert(regions_of(frame).empty());
+    av_frame_free(&frame);
+
+    printf("roi tests passed\n");
+    return 0;
+}
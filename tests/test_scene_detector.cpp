@@ -0,0 +1,170 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "scene_detector.h"
+
+
+/**
+ * SceneDetector SAD 阈值测试
+ *   平均每字节差值低于阈值为静止, 等于阈值不算; 正负差值都按绝对值累计
+ *   与上一个保留帧比较, 缓慢变化累积到阈值时检出
+ *   max_skip 限制连续跳过的帧数, 尺寸变化时重新取参考帧
+ *   向量化 SAD (sse2/avx2) 与标量实现结果一致
+ * 行宽取 16/32 的非整数倍, 覆盖向量化 SAD 的尾部处理
+ */
+
+static const int ROWS = 50;
+static const int COLS = 67;  // BGR 每行 201 字节
+
+
+static cv::Mat make_frame(int base, int rows = ROWS, int cols = COLS) {
+    cv::Mat mat(rows, cols, CV_8UC3);
+    for (int y = 0; y < rows; y++) {
+        uint8_t* row = mat.ptr(y);
+        for (int x = 0; x < cols * 3; x++) {
+            row[x] = static_cast<uint8_t>(base + (x * 7 + y * 13) % 200);
+        }
+    }
+    return mat;
+}
+
+
+static cv::Mat add(const cv::Mat& mat, int delta, bool alternate = false) {
+    cv::Mat out = mat.clone();
+    for (int y = 0; y < out.rows; y++) {
+        uint8_t* row = out.ptr(y);
+        for (int x = 0; x < out.cols * 3; x++) {
+            int d = (alternate && x % 2) ? -delta : delta;
+            row[x] = static_cast<uint8_t>(row[x] + d);
+        }
+    }
+    return out;
+}
+
+
+static void test_threshold() {
+    SceneDetector detector(2.0, 0);
+    cv::Mat ref = make_frame(20);
+    assert(!detector.is_static(ref));                  // 第一帧作为参考帧
+    assert(detector.is_static(ref) && detector.last_diff() == 0);
+    assert(detector.is_static(add(ref, 1)) && detector.last_diff() == 1);
+    assert(!detector.is_static(add(ref, 2)) && detector.last_diff() == 2);  // 等于阈值
+    // 上一帧成为参考帧
+    assert(detector.is_static(add(ref, 2)));
+    assert(detector.is_static(add(ref, 3)) && detector.last_diff() == 1);
+    // 正负交替的差值
+    assert(!detector.is_static(add(add(ref, 2), 5, true)) && detector.last_diff() == 5);
+}
+
+
+static void test_sampled_rows() {
+    // 只比较每 8 行中的第一行, 其余行的变化不计入
+    SceneDetector detector(1.0, 0);
+    cv::Mat ref = make_frame(10);
+    assert(!detector.is_static(ref));
+    cv::Mat changed = ref.clone();
+    for (int y = 1; y < ROWS; y++) {
+        if (y % 8 == 0) {
+            continue;
+        }
+        for (int x = 0; x < COLS * 3; x++) {
+            changed.ptr(y)[x] ^= 0xff;
+        }
+    }
+    assert(detector.is_static(changed) && detector.last_diff() == 0);
+    changed.ptr(8)[0] += 100;
+    assert(detector.is_static(changed));
+    assert(detector.last_diff() == 100.0 / (COLS * 3 * ((ROWS + 7) / 8)));
+}
+
+
+static void test_slow_drift() {
+    // 逐帧增加 1, 与参考帧的差值累积到阈值时检出
+    SceneDetector detector(3.0, 0);
+    cv::Mat ref = make_frame(30);
+    assert(!detector.is_static(ref));
+    assert(detector.is_static(add(ref, 1)));
+    assert(detector.is_static(add(ref, 2)));
+    assert(!detector.is_static(add(ref, 3)));
+    assert(detector.is_static(add(ref, 4)));
+}
+
+
+static void test_max_skip() {
+    SceneDetector detector(1.0, 2);
+    cv::Mat ref = make_frame(0);
+    assert(!detector.is_static(ref));
+    assert(detector.is_static(ref));
+    assert(detector.is_static(ref));
+    assert(!detector.is_static(ref));  // 连续跳过 2 帧后强制保留
+    assert(detector.is_static(ref));
+}
+
+
+static void test_size_change() {
+    SceneDetector detector(255.0, 0);
+    assert(!detector.is_static(make_frame(0)));
+    assert(!detector.is_static(make_frame(0, ROWS, COLS + 1)));
+    assert(!detector.is_static(make_frame(0, ROWS + 1, COLS + 1)));
+    assert(detector.is_static(make_frame(0, ROWS + 1, COLS + 1)));
+    // 宽行覆盖 AVX2 主循环
+    assert(!detector.is_static(make_frame(0, 16, 1921)));
+    assert(detector.is_static(add(make_frame(0, 16, 1921), 4)) && detector.last_diff() == 4);
+}
+
+
+static void test_sad_kernels() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> a(4096 + 64), b(4096 + 64);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<uint8_t>(byte(rng));
+        b[i] = static_cast<uint8_t>(byte(rng));
+    }
+    // 极值: 每字节差 255
+    std::vector<uint8_t> zeros(4096, 0), ones(4096, 255);
+    SadRowFunc scalar = find_sad_row("c");
+    assert(scalar && scalar(zeros.data(), ones.data(), 4096) == 4096u * 255);
+    for (const char* name : {"sse2", "avx2"}) {
+        SadRowFunc func = find_sad_row(name);
+        if (!func) {
+            printf("%s: not supported by cpu, skipped\n", name);
+            continue;
+        }
+        for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 63, 100, 201, 1921, 4096}) {
+            for (size_t offset : {0, 1, 7}) {
+                assert(func(a.data() + offset, b.data(), n) == scalar(a.data() + offset, b.data(), n));
+            }
+        }
+        assert(func(zeros.data(), ones.data(), 4096) == 4096u * 255);
+        assert(func(ones.data(), zeros.data(), 4095) == 4095u * 255);
+    }
+}
+
+
+static void test_invalid() {
+    bool thrown = false;
+    try {
+        SceneDetector detector(-1, 0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+
+int main() {
+    test_threshold();
+    test_sampled_rows();
+    test_slow_drift();
+    test_max_skip();
+    test_size_change();
+    test_sad_kernels();
+    test_invalid();
+    printf("scene detector tests passed\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#include "segment_catalog.h"
+
+
+/**
+ * SegmentCatalog 测试
+ *   二分查找返回采集时刻不晚于查询时刻的最近关键帧, 早于第一个关键帧时无结果
+ *   关键帧跨分段时返回所在分段的文件与结束时刻; B 帧使 pts 不单调时分段的 pts 范围仍正确
+ *   时钟回拨时关键帧沿用上一个时刻, 保持有序
+ *   只读打开可看到其他实例追加的条目, 不能写入
+ */
+
+static const std::string PATH = "test_segment_catalog";
+static const int SEGMENTS = 200;
+static const int FRAMES = 30;         // 每个分段的帧数
+static const int GOP = 5;
+static const int64_t FRAME_US = 100000;
+
+
+static void remove_files() {
+    unlink((PATH + ".segments").c_str());
+    unlink((PATH + ".keys").c_str());
+}
+
+
+static std::string segment_file(int s) {
+    return "/data/" + std::to_string(s) + ".h264";
+}
+
+
+static int64_t capture_of(int s, int f) {
+    return 1000000000LL + (static_cast<int64_t>(s) * FRAMES + f) * FRAME_US;
+}
+
+
+static void test_lookup() {
+    {
+        SegmentCatalog catalog(PATH);
+        assert(!catalog.lookup(capture_of(0, 0)));
+        for (int s = 0; s < SEGMENTS; s++) {
+            int64_t base = static_cast<int64_t>(s) * FRAMES;
+            assert(catalog.begin_segment(segment_file(s), base, capture_of(s, 0)) == 0);
+            for (int f = 0; f < FRAMES; f++) {
+                assert(catalog.add_packet(base + f, capture_of(s, f), f % GOP == 0, f * 1000) == 0);
+            }
+        }
+        assert(catalog.segment_count() == SEGMENTS);
+        assert(catalog.key_count() == SEGMENTS * FRAMES / GOP);
+    }
+
+    SegmentCatalog catalog(PATH, true);
+    assert(catalog.segment_count() == SEGMENTS);
+    assert(!catalog.lookup(capture_of(0, 0) - 1));
+    for (int s = 0; s < SEGMENTS; s += 7) {
+        for (int f = 0; f < FRAMES; f++) {
+            int key = f / GOP * GOP;
+            for (int64_t delta : {int64_t(0), FRAME_US / 2}) {
+                auto entry = catalog.lookup(capture_of(s, f) + delta);
+                assert(entry);
+                assert(entry->file == segment_file(s));
+                assert(entry->pts == static_cast<int64_t>(s) * FRAMES + key);
+                assert(entry->capture_us == capture_of(s, key));
+                assert(entry->offset == key * 1000);
+                assert(entry->segment_end_us == capture_of(s, FRAMES - 1));
+            }
+        }
+    }
+    // 晚于最后一帧: 最后一个关键帧, 由 segment_end_us 判断已超出
+    auto last = catalog.lookup(capture_of(SEGMENTS, 0) * 2);
+    assert(last && last->file == segment_file(SEGMENTS - 1) && last->capture_us < last->segment_end_us);
+    assert(catalog.begin_segment("/data/x.h264", 0, 0) < 0);  // 只读
+
+    // 重新以读写方式打开继续追加, 只读实例看到新条目
+    {
+        SegmentCatalog writer(PATH);
+        int64_t start = capture_of(SEGMENTS + 10, 0);
+        assert(writer.begin_segment("/data/late.mp4", 0, start) == 0);
+        assert(writer.add_packet(0, start, true, -1) == 0);
+    }
+    auto late = catalog.lookup(capture_of(SEGMENTS + 20, 0));
+    assert(late && late->file == "/data/late.mp4" && late->offset == -1);
+    assert(catalog.segment_count() == SEGMENTS + 1);
+    remove_files();
+}
+
+
+static void test_reordered_packets() {
+    // 解码顺序 I0 P3 B1 B2 P6 B4 B5, 采集时刻按 pts; 时钟回拨后的关键帧沿用上一个时刻
+    SegmentCatalog catalog(PATH);
+    const int64_t order[] = {0, 3, 1, 2, 6, 4, 5};
+    assert(catalog.begin_segment("/data/b.h264", 0, 1000) == 0);
+    for (int64_t pts : order) {
+        assert(catalog.add_packet(pts, 1000 + pts * 10, pts == 0, pts) == 0);
+    }
+    auto entry = catalog.lookup(1035);
+    assert(entry && entry->pts == 0 && entry->capture_us == 1000 && entry->segment_end_us == 1060);
+
+    assert(catalog.begin_segment("/data/c.h264", 7, 900) == 0);
+    assert(catalog.add_packet(7, 900, true, 0) == 0);
+    entry = catalog.lookup(2000);
+    assert(entry && entry->file == "/data/c.h264" && entry->capture_us == 1000);
+
+    assert(catalog.add_packet(8, 0, true, 0) == 0);
+    assert(catalog.key_count() == 3);
+    assert(catalog.begin_segment(std::string(300, 'a'), 0, 0) < 0);  // 路径超出记录长度
+    remove_files();
+}
+
+
+int main() {
+    remove_files();
+    test_lookup();
+    test_reordered_packets();
+    printf("segment catalog tests passed\n");
+    return 0;
+}
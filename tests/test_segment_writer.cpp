@@ -0,0 +1,196 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "async_segment_writer.h"
+#include "segment_writer.h"
+
+
+/**
+ * ContainerSegmentWriter 测试: 经自定义 AVIO 写入 BufferedFile 的 mp4/mkv 分段
+ * 用 FFmpeg 内置的 mpeg4 编码器生成包, 写出后用 avformat_open_input 重新打开, 检查:
+ *   单路视频流, 帧率与编码器一致
+ *   pts 由编码器时间基换算到封装时间基后仍为逐帧递增的序列
+ *   关闭时写入的索引 (mp4 mfra / mkv Cues, 需要回写文件) 可用于按关键帧定位
+ * 同时覆盖 direct_io: 回写经 BufferedFile::seek 关闭 O_DIRECT
+ */
+
+namespace fs = std::filesystem;
+
+static const int WIDTH = 64;
+static const int HEIGHT = 48;
+static const int FPS = 10;
+static const int FRAMES = 30;
+static const int GOP = 10;
+
+
+struct Encoded {
+    SegmentStream stream;
+    std::vector<AVPacketPtr> packets;
+};
+
+
+static Encoded encode_clip() {
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    assert(codec);
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    assert(ctx);
+    ctx->width = WIDTH;
+    ctx->height = HEIGHT;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->time_base = {1, FPS};
+    ctx->framerate = {FPS, 1};
+    ctx->gop_size = GOP;
+    ctx->max_b_frames = 0;
+    ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;  // mp4/mkv 需要 extradata
+    assert(avcodec_open2(ctx, codec, nullptr) == 0);
+
+    Encoded encoded;
+    encoded.stream = SegmentStream::from_context(ctx);
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = WIDTH;
+    frame->height = HEIGHT;
+    assert(av_frame_get_buffer(frame, 0) == 0);
+    AVPacket* pkt = av_packet_alloc();
+    auto drain = [&] {
+        while (avcodec_receive_packet(ctx, pkt) == 0) {
+            encoded.packets.emplace_back(av_packet_clone(pkt));
+            av_packet_unref(pkt);
+        }
+    };
+    for (int n = 0; n < FRAMES; n++) {
+        assert(av_frame_make_writable(frame) == 0);
+        for (int plane = 0; plane < 3; plane++) {
+            int h = plane ? HEIGHT / 2 : HEIGHT;
+            int w = plane ? WIDTH / 2 : WIDTH;
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    frame->data[plane][y * frame->linesize[plane] + x] = static_cast<uint8_t>(x + y * 2 + n * 5 + plane * 60);
+                }
+            }
+        }
+        frame->pts = n;
+        assert(avcodec_send_frame(ctx, frame) == 0);
+        drain();
+    }
+    assert(avcodec_send_frame(ctx, nullptr) == 0);
+    drain();
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    assert(static_cast<int>(encoded.packets.size()) == FRAMES);
+    return encoded;
+}
+
+
+static void write_segment(SegmentWriter& writer, const std::string& path, const Encoded& encoded) {
+    assert(writer.open(path, encoded.stream) == 0);
+    for (const auto& packet : encoded.packets) {
+        AVPacket* pkt = av_packet_clone(packet.get());
+        assert(writer.write(pkt) == 0);
+        av_packet_free(&pkt);
+    }
+    assert(writer.close() == 0);
+}
+
+
+static int index_keyframes(const AVStream* st) {
+    int keyframes = 0;
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    int count = avformat_index_get_entries_count(st);
+    for (int i = 0; i < count; i++) {
+        const AVIndexEntry* entry = avformat_index_get_entry(const_cast<AVStream*>(st), i);
+        keyframes += (entry->flags & AVINDEX_KEYFRAME) ? 1 : 0;
+    }
+#else
+    for (int i = 0; i < st->nb_index_entries; i++) {
+        keyframes += (st->index_entries[i].flags & AVINDEX_KEYFRAME) ? 1 : 0;
+    }
+#endif
+    return keyframes;
+}
+
+
+static void check_segment(const std::string& path) {
+    AVFormatContext* fmt = nullptr;
+    assert(avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) == 0);
+    assert(avformat_find_stream_info(fmt, nullptr) >= 0);
+    assert(fmt->nb_streams == 1);
+    AVStream* st = fmt->streams[0];
+    assert(st->codecpar->codec_id == AV_CODEC_ID_MPEG4);
+    assert(st->codecpar->width == WIDTH && st->codecpar->height == HEIGHT);
+    AVRational rate = av_guess_frame_rate(fmt, st, nullptr);
+    assert(rate.num == FPS * rate.den);
+
+    // pts 换算回编码器时间基后为 0, 1, 2, ...
+    const AVRational codec_tb = {1, FPS};
+    std::vector<int64_t> pts;
+    std::vector<int64_t> key_pts;
+    AVPacket* pkt = av_packet_alloc();
+    while (av_read_frame(fmt, pkt) == 0) {
+        int64_t p = av_rescale_q(pkt->pts, st->time_base, codec_tb);
+        pts.push_back(p);
+        if (pkt->flags & AV_PKT_FLAG_KEY) {
+            key_pts.push_back(p);
+        }
+        av_packet_unref(pkt);
+    }
+    std::vector<int64_t> expected;
+    for (int n = 0; n < FRAMES; n++) {
+        expected.push_back(n);
+    }
+    assert(pts == expected);
+    assert(static_cast<int>(key_pts.size()) == FRAMES / GOP);
+
+    // 索引覆盖每个关键帧, 定位到 1.5 s 时回到 1.0 s 的关键帧
+    assert(index_keyframes(st) >= FRAMES / GOP);
+    int64_t target = av_rescale_q(15, codec_tb, st->time_base);
+    assert(av_seek_frame(fmt, 0, target, AVSEEK_FLAG_BACKWARD) >= 0);
+    assert(av_read_frame(fmt, pkt) == 0);
+    assert((pkt->flags & AV_PKT_FLAG_KEY) && av_rescale_q(pkt->pts, st->time_base, codec_tb) == GOP);
+    av_packet_unref(pkt);
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+}
+
+
+int main() {
+    fs::path dir = fs::absolute("test_segment_writer.dir");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    Encoded encoded = encode_clip();
+    for (const char* container : {"mp4", "mkv"}) {
+        for (bool direct_io : {false, true}) {
+            WriterOptions options;
+            options.direct_io = direct_io;
+            options.buffer_size = 8192;  // 小于分段大小, 回写时部分数据已写出
+            std::unique_ptr<SegmentWriter> writer = make_segment_writer(container, options);
+            assert(writer && writer->global_header());
+            std::string path = (dir / (std::string(direct_io ? "direct" : "buffered") + writer->extension())).string();
+            int64_t notified = -1;
+            writer->set_close_listener([&notified](const std::string&, int64_t bytes) { notified = bytes; });
+            write_segment(*writer, path, encoded);
+            assert(notified == static_cast<int64_t>(fs::file_size(path)));
+            check_segment(path);
+
+            // 同一写出对象可连续写多个分段
+            std::string second = (dir / (std::string("second_") + (direct_io ? "direct" : "buffered") + writer->extension())).string();
+            write_segment(*writer, second, encoded);
+            check_segment(second);
+
+            // 经 I/O 线程写出结果相同
+            AsyncSegmentWriter async_writer(make_segment_writer(container, options));
+            std::string async_path = (dir / (std::string("async_") + (direct_io ? "direct" : "buffered") + writer->extension())).string();
+            write_segment(async_writer, async_path, encoded);
+            assert(async_writer.wait() == 0);
+            check_segment(async_path);
+        }
+    }
+    fs::remove_all(dir);
+    printf("segment writer tests passed\n");
+    return 0;
+}
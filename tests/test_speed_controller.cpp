@@ -0,0 +1,118 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <optional>
+#include <string>
+
+#include "speed_controller.h"
+
+
+/**
+ * SpeedController 档位决策测试 (libx264, 10 fps 即帧间隔 100 ms, 队列容量 10)
+ *   过载: 逐级换更快的 preset, 到 ultrafast 后按步长提高 CRF, 不超过上限
+ *   空闲: 先逐级恢复 CRF, 再恢复 preset, 不超过初始设置
+ *   负载适中、固定 QP、无统计数据时不调整
+ */
+
+static const size_t QUEUE_CAPACITY = 10;
+
+
+static std::optional<EncoderSettings> segment(SpeedController& ctrl, const EncoderSettings& current,
+                                              int64_t cost_ms, size_t depth) {
+    for (int i = 0; i < 30; i++) {
+        ctrl.record(cost_ms, depth);
+    }
+    return ctrl.update(current, QUEUE_CAPACITY);
+}
+
+
+static void test_overload_and_recover() {
+    EncoderSettings s;
+    SpeedController ctrl(s);
+    assert(!ctrl.update(s, QUEUE_CAPACITY));       // 本段没有帧
+    assert(!segment(ctrl, s, 70, 2));              // 适中: 70 ms, 队列 20%
+
+    auto next = segment(ctrl, s, 95, 0);           // 耗时超过帧间隔的 90%
+    assert(next && next->preset == "fast" && next->crf == -1);
+    s = *next;
+    next = segment(ctrl, s, 10, 6);                // 耗时很低但队列堆积超过一半
+    assert(next && next->preset == "faster");
+    s = *next;
+    for (const char* preset : {"veryfast", "superfast", "ultrafast"}) {
+        next = segment(ctrl, s, 200, 9);
+        assert(next && next->preset == preset && next->crf == -1);
+        s = *next;
+    }
+    // preset 已最快, 从编码器默认 CRF 23 起按步长 2 提高到上限 35
+    for (double crf : {25, 27, 29, 31, 33, 35}) {
+        next = segment(ctrl, s, 200, 9);
+        assert(next && next->preset == "ultrafast" && next->crf == crf);
+        s = *next;
+    }
+    assert(!segment(ctrl, s, 200, 9));
+
+    // 空闲: 耗时低于帧间隔一半且队列几乎为空; 先恢复 CRF, 回到默认值时恢复为未设置
+    for (double crf : {33, 31, 29, 27, 25, -1}) {
+        next = segment(ctrl, s, 10, 0);
+        assert(next && next->preset == "ultrafast" && next->crf == crf);
+        s = *next;
+    }
+    for (const char* preset : {"superfast", "veryfast", "faster", "fast", "medium"}) {
+        next = segment(ctrl, s, 10, 0);
+        assert(next && next->preset == preset && next->crf == -1);
+        s = *next;
+    }
+    assert(!segment(ctrl, s, 10, 0));              // 不超过初始 preset
+    assert(!segment(ctrl, s, 40, 1));              // 队列 10% 不算空闲
+}
+
+
+static void test_explicit_crf() {
+    EncoderSettings s;
+    s.preset = "ultrafast";
+    s.crf = 30;
+    SpeedController ctrl(s);
+    auto next = segment(ctrl, s, 200, 0);
+    assert(next && next->crf == 32);
+    s = *next;
+    next = segment(ctrl, s, 10, 0);
+    assert(next && next->crf == 30);               // 恢复到设置值而不是未设置
+    s = *next;
+    assert(!segment(ctrl, s, 10, 0));
+}
+
+
+static void test_fixed_qp() {
+    EncoderSettings s;
+    s.preset = "superfast";
+    s.qp = 28;
+    SpeedController ctrl(s);
+    auto next = segment(ctrl, s, 200, 0);
+    assert(next && next->preset == "ultrafast" && next->qp == 28);
+    s = *next;
+    assert(!segment(ctrl, s, 200, 0));             // 固定 QP 时不调整 CRF
+}
+
+
+static void test_unknown_preset() {
+    EncoderSettings s;
+    s.preset = "placebo";                          // 不在档位表中, 只调整 CRF
+    SpeedController ctrl(s);
+    auto next = segment(ctrl, s, 200, 0);
+    assert(next && next->preset == "placebo" && next->crf == 25);
+    s = *next;
+    next = segment(ctrl, s, 10, 0);
+    assert(next && next->preset == "placebo" && next->crf == -1);
+    s = *next;
+    assert(!segment(ctrl, s, 10, 0));
+}
+
+
+int main() {
+    test_overload_and_recover();
+    test_explicit_crf();
+    test_fixed_qp();
+    test_unknown_preset();
+    printf("speed controller tests passed\n");
+    return 0;
+}
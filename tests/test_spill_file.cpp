@@ -0,0 +1,109 @@
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "spill_file.h"
+
+
+/**
+ * SpillFile 环形缓冲测试
+ *   尾部空间不足时回绕到文件起始处, 与未读出的数据重叠时拒绝写入
+ *   按写入顺序读回, 像素数据、入队时刻与感兴趣区域保持不变
+ */
+
+static const size_t CAPACITY = 100;
+
+
+static FrameItem make_frame(int bytes, uint8_t seed) {
+    cv::Mat mat(1, bytes, CV_8UC1);
+    for (int i = 0; i < bytes; i++) {
+        mat.ptr(0)[i] = static_cast<uint8_t>(seed + i);
+    }
+    FrameItem item(std::move(mat));
+    item.enqueue_us = seed;
+    item.rois.push_back({seed, 0, 1, 1, 0.5f});
+    return item;
+}
+
+
+static void expect_frame(SpillFile& spill, int bytes, uint8_t seed) {
+    assert(spill.front_bytes() == static_cast<size_t>(bytes));
+    std::optional<FrameItem> item = spill.read();
+    assert(item.has_value());
+    assert(item->mat.rows == 1 && item->mat.cols == bytes && item->mat.type() == CV_8UC1);
+    for (int i = 0; i < bytes; i++) {
+        assert(item->mat.ptr(0)[i] == static_cast<uint8_t>(seed + i));
+    }
+    assert(item->enqueue_us == seed);
+    assert(item->rois.size() == 1 && item->rois[0].x == seed);
+}
+
+
+static void test_wraparound(const std::string& path) {
+    SpillFile spill(path, CAPACITY);
+    assert(spill.empty() && !spill.read().has_value());
+
+    assert(spill.write(make_frame(40, 1)));   // [0, 40)
+    assert(spill.write(make_frame(40, 2)));   // [40, 80)
+    assert(!spill.write(make_frame(30, 3)));  // 尾部剩 20, 起始处被占用
+    assert(spill.count() == 2);
+
+    expect_frame(spill, 40, 1);
+    assert(spill.write(make_frame(30, 3)));   // 回绕到 [0, 30)
+    assert(spill.write(make_frame(10, 4)));   // [30, 40), 恰好写满
+    assert(!spill.write(make_frame(1, 5)));   // 与最早的帧重叠
+
+    expect_frame(spill, 40, 2);
+    assert(spill.write(make_frame(60, 5)));   // 头部回到 0, 写入尾部 [40, 100)
+    assert(!spill.write(make_frame(1, 6)));
+
+    expect_frame(spill, 30, 3);
+    expect_frame(spill, 10, 4);
+    expect_frame(spill, 60, 5);
+    assert(spill.empty() && spill.front_bytes() == 0);
+
+    // 读空后从起始处重新写入, 可以占满整个文件
+    assert(spill.write(make_frame(CAPACITY, 7)));
+    assert(!spill.write(make_frame(1, 8)));
+    expect_frame(spill, CAPACITY, 7);
+}
+
+
+static void test_reject(const std::string& path) {
+    SpillFile spill(path, CAPACITY);
+    assert(!spill.write(make_frame(CAPACITY + 1, 1)));
+    assert(!spill.write(FrameItem(cv::Mat())));
+    assert(spill.empty());
+}
+
+
+static void test_non_continuous(const std::string& path) {
+    // 行跨度大于行宽的图像逐行写入
+    std::vector<uint8_t> buffer(4 * 8);
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] = static_cast<uint8_t>(i);
+    }
+    cv::Mat view(4, 2, CV_8UC3, buffer.data(), 8);
+    SpillFile spill(path, CAPACITY);
+    assert(spill.write(FrameItem(view)));
+    std::optional<FrameItem> item = spill.read();
+    assert(item.has_value() && item->mat.rows == 4 && item->mat.cols == 2 && item->mat.type() == CV_8UC3);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 6; x++) {
+            assert(item->mat.ptr(y)[x] == buffer[y * 8 + x]);
+        }
+    }
+}
+
+
+int main() {
+    std::string path = "test_spill_file.tmp";
+    test_wraparound(path);
+    test_reject(path);
+    test_non_continuous(path);
+    printf("spill file tests passed\n");
+    return 0;
+}